@@ -38,6 +38,8 @@
 #include "../project.h"
 
 #define COMPILE_PROCESS_END "---//END//----"
+#define ISSUES_BATCH_MAX_COUNT 200
+#define ISSUES_BATCH_MAX_WAIT_TIME 100 //ms
 
 Compiler::Compiler(const QString &filename, bool onlyCheckSyntax):
     QThread{},
@@ -54,6 +56,7 @@ void Compiler::run()
 {
     emit compileStarted();
     auto action = finally([this]{
+        flushIssues();
         emit compileFinished(mFilename);
     });
     try {
@@ -244,7 +247,7 @@ void Compiler::processOutput(QString &line)
 {
     if (line == COMPILE_PROCESS_END) {
         if (mLastIssue) {
-            emit compileIssue(mLastIssue);
+            addIssue(mLastIssue);
             mLastIssue.reset();
         }
         return;
@@ -257,7 +260,7 @@ void Compiler::processOutput(QString &line)
             mLastIssue->filename = getFileNameFromOutputLine(line);
             //qDebug()<<line;
             mLastIssue->line = getLineNumberFromOutputLine(line);
-            emit compileIssue(mLastIssue);
+            addIssue(mLastIssue);
             mLastIssue.reset();
             return;
     }
@@ -274,7 +277,7 @@ void Compiler::processOutput(QString &line)
             issue->column = getColunmnFromOutputLine(line) - 1; // editor ch starts from 0, gdb col starts from 1
         issue->type = getIssueTypeFromOutputLine(line);
         issue->description = inFilePrefix + issue->filename;
-        emit compileIssue(issue);
+        addIssue(issue);
         return;
     } else if(line.startsWith(fromPrefix)) {
         line.remove(0,fromPrefix.length());
@@ -284,7 +287,7 @@ void Compiler::processOutput(QString &line)
             issue->column = getColunmnFromOutputLine(line) - 1; // editor ch starts from 0, gdb col starts from 1
         issue->type = getIssueTypeFromOutputLine(line);
         issue->description = "                 from " + issue->filename;
-        emit compileIssue(issue);
+        addIssue(issue);
         return;
     }
 
@@ -309,7 +312,7 @@ void Compiler::processOutput(QString &line)
                     i++;
                 }
                 mLastIssue->endColumn = mLastIssue->column+i-pos;
-                emit compileIssue(mLastIssue);
+                addIssue(mLastIssue);
                 mLastIssue.reset();
             }
         }
@@ -317,7 +320,7 @@ void Compiler::processOutput(QString &line)
     }
 
     if (mLastIssue) {
-        emit compileIssue(mLastIssue);
+        addIssue(mLastIssue);
         mLastIssue.reset();
     }
 
@@ -339,11 +342,29 @@ void Compiler::processOutput(QString &line)
     if (issue->line<0 && (issue->filename=="ld" || issue->filename=="lld")) {
         mLastIssue = issue;
     } else if (issue->line<0) {
-        emit compileIssue(issue);
+        addIssue(issue);
     } else
         mLastIssue = issue;
 }
 
+void Compiler::addIssue(PCompileIssue issue)
+{
+    if (mPendingIssues.isEmpty())
+        mPendingIssuesTimer.start();
+    mPendingIssues.append(issue);
+    if (mPendingIssues.count() >= ISSUES_BATCH_MAX_COUNT
+            || mPendingIssuesTimer.elapsed() >= ISSUES_BATCH_MAX_WAIT_TIME)
+        flushIssues();
+}
+
+void Compiler::flushIssues()
+{
+    if (mPendingIssues.isEmpty())
+        return;
+    emit compileIssues(mPendingIssues);
+    mPendingIssues.clear();
+}
+
 void Compiler::stopCompile()
 {
     mStop = true;
@@ -807,6 +828,9 @@ void Compiler::runCommand(const QString &cmd, const QStringList &arguments, cons
         if (process.state()!=QProcess::Running) {
             break;
         }
+        // don't hold issues while the compiler is busy without output
+        if (!mPendingIssues.isEmpty() && mPendingIssuesTimer.elapsed() >= ISSUES_BATCH_MAX_WAIT_TIME)
+            flushIssues();
         if (mStop) {
             process.terminate();
         }
@@ -17,6 +17,7 @@
 #ifndef COMPILER_H
 #define COMPILER_H
 
+#include <QElapsedTimer>
 #include <QThread>
 #include "../settings.h"
 #include "../common.h"
@@ -52,7 +53,7 @@ signals:
     void compileStarted();
     void compileFinished(const QString& filename);
     void compileOutput(const QString& msg);
-    void compileIssue(PCompileIssue issue);
+    void compileIssues(QVector<PCompileIssue> issues);
     void compileErrorOccured(const QString& reason);
 public slots:
     void stopCompile();
@@ -60,6 +61,9 @@ public slots:
 protected:
     void run() override;
     void processOutput(QString& line);
+    // issues are sent in batches, so the ui isn't flooded by compilers printing lots of them
+    void addIssue(PCompileIssue issue);
+    void flushIssues();
     virtual QString getFileNameFromOutputLine(QString &line);
     virtual int getLineNumberFromOutputLine(QString &line);
     virtual int getColunmnFromOutputLine(QString &line);
@@ -111,6 +115,8 @@ protected:
 
 private:
     bool mStop;
+    QVector<PCompileIssue> mPendingIssues;
+    QElapsedTimer mPendingIssuesTimer;
 };
 
 
@@ -112,13 +112,13 @@ void CompilerManager::compile(const QString& filename, FileType fileType, const
         mCompiler->setRebuild(rebuild);
         connect(mCompiler, &Compiler::finished, mCompiler, &QObject::deleteLater);
         connect(mCompiler, &Compiler::compileFinished, this, &CompilerManager::onCompileFinished);
-        connect(mCompiler, &Compiler::compileIssue, this, &CompilerManager::onCompileIssue);
+        connect(mCompiler, &Compiler::compileIssues, this, &CompilerManager::onCompileIssues);
         if (mMainWindow) {
             connect(mCompiler, &Compiler::compileStarted, mMainWindow, &MainWindow::onCompileStarted);
             connect(mCompiler, &Compiler::compileStarted, mMainWindow, &MainWindow::clearToolsOutput);
 
             connect(mCompiler, &Compiler::compileOutput, mMainWindow, &MainWindow::logToolsOutput);
-            connect(mCompiler, &Compiler::compileIssue, mMainWindow, &MainWindow::onCompileIssue);
+            connect(mCompiler, &Compiler::compileIssues, mMainWindow, &MainWindow::onCompileIssues);
             connect(mCompiler, &Compiler::compileErrorOccured, mMainWindow, &MainWindow::onCompileErrorOccured);
         }
         mCompiler->start();
@@ -146,13 +146,13 @@ void CompilerManager::compileProject(std::shared_ptr<Project> project, bool rebu
         connect(mCompiler, &Compiler::finished, mCompiler, &QObject::deleteLater);
         connect(mCompiler, &Compiler::compileFinished, this, &CompilerManager::onCompileFinished);
 
-        connect(mCompiler, &Compiler::compileIssue, this, &CompilerManager::onCompileIssue);
+        connect(mCompiler, &Compiler::compileIssues, this, &CompilerManager::onCompileIssues);
         if (mMainWindow) {
             connect(mCompiler, &Compiler::compileStarted, mMainWindow, &MainWindow::onProjectCompileStarted);
             connect(mCompiler, &Compiler::compileStarted, mMainWindow, &MainWindow::clearToolsOutput);
 
             connect(mCompiler, &Compiler::compileOutput, mMainWindow, &MainWindow::logToolsOutput);
-            connect(mCompiler, &Compiler::compileIssue, mMainWindow, &MainWindow::onCompileIssue);
+            connect(mCompiler, &Compiler::compileIssues, mMainWindow, &MainWindow::onCompileIssues);
             connect(mCompiler, &Compiler::compileErrorOccured, mMainWindow, &MainWindow::onCompileErrorOccured);
         }
         mCompiler->start();
@@ -182,13 +182,13 @@ void CompilerManager::cleanProject(std::shared_ptr<Project> project)
         connect(mCompiler, &Compiler::finished, mCompiler, &QObject::deleteLater);
         connect(mCompiler, &Compiler::compileFinished, this, &CompilerManager::onCompileFinished);
 
-        connect(mCompiler, &Compiler::compileIssue, this, &CompilerManager::onCompileIssue);
+        connect(mCompiler, &Compiler::compileIssues, this, &CompilerManager::onCompileIssues);
         if (mMainWindow) {
             connect(mCompiler, &Compiler::compileStarted, mMainWindow, &MainWindow::onProjectCompileStarted);
             connect(mCompiler, &Compiler::compileStarted, mMainWindow, &MainWindow::clearToolsOutput);
 
             connect(mCompiler, &Compiler::compileOutput, mMainWindow, &MainWindow::logToolsOutput);
-            connect(mCompiler, &Compiler::compileIssue, mMainWindow, &MainWindow::onCompileIssue);
+            connect(mCompiler, &Compiler::compileIssues, mMainWindow, &MainWindow::onCompileIssues);
             connect(mCompiler, &Compiler::compileErrorOccured, mMainWindow, &MainWindow::onCompileErrorOccured);
         }
         mCompiler->start();
@@ -237,11 +237,11 @@ void CompilerManager::checkSyntax(const QString &filename, const QByteArray& enc
             mBackgroundSyntaxChecker->setParserForFile(getParserForFile(filename));
         mBackgroundSyntaxChecker->setProject(project);
         connect(mBackgroundSyntaxChecker, &Compiler::finished, mBackgroundSyntaxChecker, &QThread::deleteLater);
-        connect(mBackgroundSyntaxChecker, &Compiler::compileIssue, this, &CompilerManager::onSyntaxCheckIssue);
+        connect(mBackgroundSyntaxChecker, &Compiler::compileIssues, this, &CompilerManager::onSyntaxCheckIssues);
         connect(mBackgroundSyntaxChecker, &Compiler::compileFinished, this, &CompilerManager::onSyntaxCheckFinished);
         if (mMainWindow) {
             connect(mBackgroundSyntaxChecker, &Compiler::compileStarted, mMainWindow, &MainWindow::onSyntaxCheckStarted);
-            connect(mBackgroundSyntaxChecker, &Compiler::compileIssue, mMainWindow, &MainWindow::onCompileIssue);
+            connect(mBackgroundSyntaxChecker, &Compiler::compileIssues, mMainWindow, &MainWindow::onCompileIssues);
             connect(mBackgroundSyntaxChecker, &Compiler::compileErrorOccured, mMainWindow, &MainWindow::onCompileErrorOccured);
             //connect(mBackgroundSyntaxChecker, &Compiler::compileOutput, mMainWindow, &MainWindow::logToolsOutput);
         }
@@ -394,6 +394,8 @@ void CompilerManager::doRunProblem(const QString &filename, const QString &argum
         execRunner->setExecTimeout(timeLimit);
     if (memoryLimit)
         execRunner->setMemoryLimit(memoryLimit);
+    execRunner->setConcurrency(pSettings->executor().caseConcurrency());
+    execRunner->setRedirectOutputToFile(pSettings->executor().redirectCaseOutputToFile());
     connect(mRunner, &Runner::finished, this ,&CompilerManager::onRunnerTerminated);
     connect(mRunner, &Runner::finished, mRunner ,&Runner::deleteLater);
     if (mMainWindow) {
@@ -483,11 +485,13 @@ void CompilerManager::onRunnerPausing()
     mTempFileOwner=nullptr;
 }
 
-void CompilerManager::onCompileIssue(PCompileIssue issue)
+void CompilerManager::onCompileIssues(QVector<PCompileIssue> issues)
 {
-    if (issue->type == CompileIssueType::Error)
-        mCompileErrorCount++;
-    mCompileIssueCount++;
+    foreach (const PCompileIssue& issue, issues) {
+        if (issue->type == CompileIssueType::Error)
+            mCompileErrorCount++;
+    }
+    mCompileIssueCount += issues.count();
 }
 
 void CompilerManager::onSyntaxCheckFinished(const QString& filename)
@@ -497,13 +501,15 @@ void CompilerManager::onSyntaxCheckFinished(const QString& filename)
     emit compileFinished(filename, true);
 }
 
-void CompilerManager::onSyntaxCheckIssue(PCompileIssue issue)
+void CompilerManager::onSyntaxCheckIssues(QVector<PCompileIssue> issues)
 {
-    if (issue->type == CompileIssueType::Error)
-        mSyntaxCheckErrorCount++;
-    if (issue->type == CompileIssueType::Error ||
-            issue->type == CompileIssueType::Warning)
-        mSyntaxCheckIssueCount++;
+    foreach (const PCompileIssue& issue, issues) {
+        if (issue->type == CompileIssueType::Error)
+            mSyntaxCheckErrorCount++;
+        if (issue->type == CompileIssueType::Error ||
+                issue->type == CompileIssueType::Warning)
+            mSyntaxCheckIssueCount++;
+    }
 }
 
 ProjectCompiler *CompilerManager::createProjectCompiler(std::shared_ptr<Project> project)
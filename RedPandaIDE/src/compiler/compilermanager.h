@@ -94,9 +94,9 @@ private slots:
     void onRunnerTerminated();
     void onRunnerPausing();
     void onCompileFinished(const QString& filename);
-    void onCompileIssue(PCompileIssue issue);
+    void onCompileIssues(QVector<PCompileIssue> issues);
     void onSyntaxCheckFinished(const QString& filename);
-    void onSyntaxCheckIssue(PCompileIssue issue);
+    void onSyntaxCheckIssues(QVector<PCompileIssue> issues);
 private:
     ProjectCompiler* createProjectCompiler(std::shared_ptr<Project> project);
     PCppParser getParserForFile(const QString& filename);
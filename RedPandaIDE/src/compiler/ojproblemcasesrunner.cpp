@@ -18,18 +18,203 @@
 #include "../utils.h"
 #include "../settings.h"
 #include "../systemconsts.h"
+#include <QDir>
 #include <QElapsedTimer>
+#include <QFile>
 #include <QProcess>
+#include <QTemporaryFile>
+#include <QThreadPool>
 #ifdef Q_OS_WINDOWS
 #include <psapi.h>
 #endif
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// size of the beginning and the end of the output file shown as its preview
+const qint64 OUTPUT_PREVIEW_SIZE = 32*1024;
+
+// Shows only the beginning and the end of a big output file, cut at line breaks.
+void loadOutputPreview(POJProblemCase problemCase)
+{
+    problemCase->output.clear();
+    problemCase->outputHeadLineCounts = -1;
+    problemCase->outputTailLineCounts = 0;
+    QFile file(problemCase->outputFileName);
+    if (!file.open(QFile::ReadOnly))
+        return;
+    if (file.size() <= 2*OUTPUT_PREVIEW_SIZE) {
+        problemCase->output = QString::fromLocal8Bit(file.readAll());
+        return;
+    }
+    QByteArray head = file.read(OUTPUT_PREVIEW_SIZE);
+    int pos = head.lastIndexOf('\n');
+    if (pos >= 0)
+        head.truncate(pos + 1);
+    else
+        head.append('\n');
+    file.seek(file.size() - OUTPUT_PREVIEW_SIZE);
+    QByteArray tail = file.read(OUTPUT_PREVIEW_SIZE);
+    pos = tail.indexOf('\n');
+    if (pos >= 0 && pos < tail.length() - 1)
+        tail.remove(0, pos + 1);
+    qint64 omitted = file.size() - head.length() - tail.length();
+    problemCase->outputHeadLineCounts = head.count('\n');
+    problemCase->outputTailLineCounts = tail.count('\n') + (tail.endsWith('\n') ? 0 : 1);
+    problemCase->output = QString::fromLocal8Bit(head)
+            + OJProblemCasesRunner::tr("--- %1 bytes omitted ---").arg(omitted) + "\n"
+            + QString::fromLocal8Bit(tail);
+}
+
+void removeOutputFile(POJProblemCase problemCase)
+{
+    if (!problemCase->outputFileName.isEmpty()) {
+        QFile::remove(problemCase->outputFileName);
+        problemCase->outputFileName.clear();
+    }
+    problemCase->outputHeadLineCounts = -1;
+    problemCase->outputTailLineCounts = 0;
+}
+
+#ifdef Q_OS_LINUX
+struct ProcessUsage {
+    qulonglong cpuTime = 0; // in milliseconds
+    qulonglong peakMemory = 0; // peak resident set size, in bytes
+};
+
+// Limits the cpu time of the child. It's called between fork and exec, so only async-signal-safe calls are allowed.
+void applyCpuTimeLimit(rlim_t seconds)
+{
+    if (seconds == 0)
+        return;
+    struct rlimit limit;
+    // the child gets SIGXCPU at the soft limit, and SIGKILL at the hard limit
+    limit.rlim_cur = seconds;
+    limit.rlim_max = seconds + 1;
+    setrlimit(RLIMIT_CPU, &limit);
+}
+
+class LimitedProcess : public QProcess
+{
+public:
+    explicit LimitedProcess(QObject *parent = nullptr):
+        QProcess{parent},
+        mCpuTimeLimit{0}
+    {
+    }
+
+    void setCpuTimeLimit(rlim_t seconds) {
+        mCpuTimeLimit = seconds;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        setChildProcessModifier([seconds]{
+            applyCpuTimeLimit(seconds);
+        });
+#endif
+    }
+protected:
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    void setupChildProcess() override {
+        applyCpuTimeLimit(mCpuTimeLimit);
+    }
+#endif
+private:
+    rlim_t mCpuTimeLimit;
+};
+
+// Samples the usage of a running (or not yet reaped) child from /proc.
+bool readProcessUsage(qint64 pid, ProcessUsage& usage)
+{
+    QFile statFile(QString("/proc/%1/stat").arg(pid));
+    if (!statFile.open(QFile::ReadOnly))
+        return false;
+    QByteArray stat = statFile.readAll();
+    // the command name may contain spaces, so fields are counted from its closing parenthesis
+    int pos = stat.lastIndexOf(')');
+    if (pos < 0)
+        return false;
+    QList<QByteArray> fields = stat.mid(pos + 2).split(' ');
+    // utime and stime are the 14th and 15th fields, and the first field here is the 3rd
+    long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    if (fields.count() < 13 || ticksPerSecond <= 0)
+        return false;
+    qulonglong ticks = fields[11].toULongLong() + fields[12].toULongLong();
+    usage.cpuTime = std::max(usage.cpuTime, ticks * 1000 / ticksPerSecond);
+
+    QFile statusFile(QString("/proc/%1/status").arg(pid));
+    if (statusFile.open(QFile::ReadOnly)) {
+        foreach (const QByteArray& line, statusFile.readAll().split('\n')) {
+            if (line.startsWith("VmHWM:")) {
+                qulonglong kb = line.mid(6).trimmed().split(' ').first().toULongLong();
+                usage.peakMemory = std::max(usage.peakMemory, kb * 1024);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+// Gets the final usage of an exited child without reaping it, so QProcess can still collect its exit status.
+bool peekExitedProcessUsage(qint64 pid, ProcessUsage& usage)
+{
+    siginfo_t info;
+    memset(&info, 0, sizeof(info));
+    struct rusage ru;
+    memset(&ru, 0, sizeof(ru));
+    // unlike the libc wrapper, the raw syscall also reports the rusage (as wait4 does)
+    if (syscall(SYS_waitid, P_PID, (pid_t)pid, &info, WEXITED | WNOHANG | WNOWAIT, &ru) != 0
+            || info.si_pid != pid)
+        return false;
+    usage.cpuTime = (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000ULL
+            + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000;
+    usage.peakMemory = std::max(usage.peakMemory, (qulonglong)ru.ru_maxrss * 1024);
+    return true;
+}
+
+int openPidfd(qint64 pid)
+{
+#ifdef SYS_pidfd_open
+    return syscall(SYS_pidfd_open, (pid_t)pid, 0);
+#else
+    Q_UNUSED(pid);
+    return -1;
+#endif
+}
+
+// Returns true if the process of the pidfd has exited.
+bool waitForPidfd(int pidfd, int msecs)
+{
+    struct pollfd pfd;
+    pfd.fd = pidfd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int ret;
+    do {
+        ret = poll(&pfd, 1, msecs);
+    } while (ret < 0 && errno == EINTR);
+    return ret > 0;
+}
+#endif
+
+}
 
 
 OJProblemCasesRunner::OJProblemCasesRunner(const QString& filename, const QStringList& arguments, const QString& workDir,
                                            const QVector<POJProblemCase>& problemCases, QObject *parent):
     Runner(filename,arguments,workDir,parent),
     mExecTimeout(0),
-    mMemoryLimit(0)
+    mMemoryLimit(0),
+    mConcurrency(0),
+    mRedirectOutputToFile(false),
+    mFinishedCount(0)
 {
     mProblemCases = problemCases;
     mBufferSize = 8192;
@@ -41,7 +226,10 @@ OJProblemCasesRunner::OJProblemCasesRunner(const QString& filename, const QStrin
                                            POJProblemCase problemCase, QObject *parent):
     Runner(filename,arguments,workDir,parent),
     mExecTimeout(0),
-    mMemoryLimit(0)
+    mMemoryLimit(0),
+    mConcurrency(0),
+    mRedirectOutputToFile(false),
+    mFinishedCount(0)
 {
     mProblemCases.append(problemCase);
     mBufferSize = 8192;
@@ -49,13 +237,24 @@ OJProblemCasesRunner::OJProblemCasesRunner(const QString& filename, const QStrin
     setWaitForFinishTime(100);
 }
 
-void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
+void OJProblemCasesRunner::runCase(POJProblemCase problemCase)
 {
-    emit caseStarted(problemCase->id(),index, mProblemCases.count());
-    auto action = finally([this,&index, &problemCase]{
-        emit caseFinished(problemCase->id(), index, mProblemCases.count());
+    emit caseStarted(problemCase->id(), mFinishedCount.loadRelaxed(), mProblemCases.count());
+    auto action = finally([this, &problemCase]{
+        emit caseFinished(problemCase->id(), mFinishedCount.fetchAndAddRelaxed(1)+1, mProblemCases.count());
     });
+#ifdef Q_OS_LINUX
+    LimitedProcess process;
+    // the limit is only a backstop, time limits are checked by the measured cpu time below
+    if (mExecTimeout>0)
+        process.setCpuTimeLimit((mExecTimeout + 999) / 1000 + 1);
+    ProcessUsage usage;
+    bool usageMeasured = false;
+    bool usageFinal = false;
+    int pidfd = -1;
+#else
     QProcess process;
+#endif
     bool errorOccurred = false;
     QByteArray readed;
     QByteArray buffer;
@@ -63,6 +262,7 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
     int noOutputTime = 0;
     QElapsedTimer elapsedTimer;
     bool execTimeouted = false;
+    bool memoryExceeded = false;
     process.setProgram(mFilename);
     process.setArguments(mArguments);
     process.setWorkingDirectory(mWorkDir);
@@ -95,6 +295,17 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
         errorOccurred= true;
     });
     problemCase->output.clear();
+    removeOutputFile(problemCase);
+    if (mRedirectOutputToFile) {
+        // the output goes to the file without passing through the ide
+        QTemporaryFile outputFile(QDir::tempPath()+"/redpanda_case_XXXXXX.out");
+        outputFile.setAutoRemove(false);
+        if (outputFile.open()) {
+            problemCase->outputFileName = outputFile.fileName();
+            outputFile.close();
+            process.setStandardOutputFile(problemCase->outputFileName);
+        }
+    }
     process.start();
     process.waitForStarted(5000);
 #ifdef Q_OS_WIN
@@ -102,6 +313,10 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
     if (process.processId()!=0) {
         hProcess = OpenProcess(PROCESS_ALL_ACCESS,FALSE,process.processId());
     }
+#endif
+#ifdef Q_OS_LINUX
+    if (process.processId()!=0)
+        pidfd = openPidfd(process.processId());
 #endif
     if (process.state()==QProcess::Running) {
         if (fileExists(problemCase->inputFileName()))
@@ -117,17 +332,44 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
             writeChannelClosed = true;
             process.closeWriteChannel();
         }
+#ifdef Q_OS_LINUX
+        if (pidfd>=0) {
+            // Wait on the pidfd instead of QProcess, so the exited child can be measured before QProcess reaps it.
+            // Don't wait long while the pipes are busy, or the child would be blocked on them.
+            bool pipesBusy = process.bytesToWrite()>0 || !readed.isEmpty();
+            if (waitForPidfd(pidfd, pipesBusy?1:mWaitForFinishTime) && !usageFinal) {
+                usageFinal = peekExitedProcessUsage(process.processId(), usage);
+                usageMeasured |= usageFinal;
+            }
+            process.waitForFinished(0);
+        } else
+            process.waitForFinished(mWaitForFinishTime);
+#else
         process.waitForFinished(mWaitForFinishTime);
+#endif
         if (process.state()!=QProcess::Running) {
             break;
         }
+#ifdef Q_OS_LINUX
+        if (!usageFinal)
+            usageMeasured |= readProcessUsage(process.processId(), usage);
+        if (mExecTimeout>0 && usage.cpuTime>(qulonglong)mExecTimeout)
+            execTimeouted = true;
+        if (mMemoryLimit>0 && usage.peakMemory>mMemoryLimit)
+            memoryExceeded = true;
+#endif
         if (mExecTimeout>0) {
             int msec = elapsedTimer.elapsed();
+#ifdef Q_OS_LINUX
+            // cpu time is checked above, the wall clock only catches children sleeping or blocked on io
+            if (usageMeasured)
+                msec /= 2;
+#endif
             if (msec>mExecTimeout) {
                 execTimeouted=true;
             }
         }
-        if (mStop || execTimeouted) {
+        if (mStop || execTimeouted || memoryExceeded) {
             process.terminate();
             process.kill();
             break;
@@ -173,11 +415,24 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
             problemCase->runningTime=(double)t/10000;
         }
     }
+#endif
+#ifdef Q_OS_LINUX
+    if (pidfd>=0)
+        close(pidfd);
+    if (usageMeasured) {
+        problemCase->runningTime = usage.cpuTime;
+        problemCase->runningMemory = usage.peakMemory;
+        // also catches children killed by the cpu time limit
+        if (mExecTimeout>0 && problemCase->runningTime>(qulonglong)mExecTimeout)
+            execTimeouted = true;
+    }
 #endif
     if (execTimeouted) {
+        removeOutputFile(problemCase);
         problemCase->output = tr("Time limit exceeded!");
         emit resetOutput(problemCase->id(), problemCase->output);
     } else if (mMemoryLimit>0 && problemCase->runningMemory>mMemoryLimit) {
+        removeOutputFile(problemCase);
         problemCase->output = tr("Memory limit exceeded!");
         emit resetOutput(problemCase->id(), problemCase->output);
     } else {
@@ -186,11 +441,16 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
             if (!s.isEmpty())
                 emit logStderrOutput(s);
         }
-        if (process.state() == QProcess::ProcessState::NotRunning)
-            buffer += process.readAll();
-        emit newOutputGetted(problemCase->id(),QString::fromLocal8Bit(buffer));
-        output.append(buffer);
-        problemCase->output = QString::fromLocal8Bit(output);
+        if (!problemCase->outputFileName.isEmpty()) {
+            loadOutputPreview(problemCase);
+            emit resetOutput(problemCase->id(), problemCase->output);
+        } else {
+            if (process.state() == QProcess::ProcessState::NotRunning)
+                buffer += process.readAll();
+            emit newOutputGetted(problemCase->id(),QString::fromLocal8Bit(buffer));
+            output.append(buffer);
+            problemCase->output = QString::fromLocal8Bit(output);
+        }
 
         if (errorOccurred) {
             //qDebug()<<"process error:"<<process.error();
@@ -223,12 +483,40 @@ void OJProblemCasesRunner::run()
     auto action = finally([this]{
         emit terminated();
     });
+    mFinishedCount.storeRelaxed(0);
+    // Each case is run and timed by its own worker, and results are reported when it finishes.
+    QThreadPool pool;
+    int concurrency = mConcurrency>0 ? mConcurrency : QThread::idealThreadCount();
+    pool.setMaxThreadCount(std::max(1, std::min(concurrency, (int)mProblemCases.size())));
     for (int i=0; i < mProblemCases.size(); i++) {
-        if (mStop)
-            break;
         POJProblemCase problemCase = mProblemCases[i];
-        runCase(i,problemCase);
+        pool.start([this, problemCase]{
+            if (mStop)
+                return;
+            runCase(problemCase);
+        });
     }
+    pool.waitForDone();
+}
+
+int OJProblemCasesRunner::concurrency() const
+{
+    return mConcurrency;
+}
+
+void OJProblemCasesRunner::setConcurrency(int newConcurrency)
+{
+    mConcurrency = newConcurrency;
+}
+
+bool OJProblemCasesRunner::redirectOutputToFile() const
+{
+    return mRedirectOutputToFile;
+}
+
+void OJProblemCasesRunner::setRedirectOutputToFile(bool newRedirectOutputToFile)
+{
+    mRedirectOutputToFile = newRedirectOutputToFile;
 }
 
 int OJProblemCasesRunner::execTimeout() const
@@ -18,6 +18,7 @@
 #define OJPROBLEMCASESRUNNER_H
 
 #include "runner.h"
+#include <QAtomicInt>
 #include <QVector>
 #include "../problems/ojproblemset.h"
 
@@ -52,14 +53,23 @@ public:
     bool includeOutputFromStderr() const;
     void setIncludeOutputFromStderr(bool newIncludeOutputFromStderr);
 
+    //max count of cases running at the same time, 0 means the count of cpu cores
+    int concurrency() const;
+    void setConcurrency(int newConcurrency);
+
+    //save the output of cases to temporary files, instead of keeping it in memory
+    bool redirectOutputToFile() const;
+    void setRedirectOutputToFile(bool newRedirectOutputToFile);
+
 signals:
+    // current is the count of finished cases
     void caseStarted(const QString &caseId, int current, int total);
     void caseFinished(const QString &caseId, int current, int total);
     void newOutputGetted(const QString &caseId, const QString &newOutputLine);
     void resetOutput(const QString &caseId, const QString &newOutputLine);
     void logStderrOutput(const QString& msg);
 private:
-    void runCase(int index, POJProblemCase problemCase);
+    void runCase(POJProblemCase problemCase);
 private:
     QVector<POJProblemCase> mProblemCases;
 
@@ -72,6 +82,9 @@ private:
     int mExecTimeout;
     size_t mMemoryLimit;
     bool mIncludeOutputFromStderr;
+    int mConcurrency;
+    bool mRedirectOutputToFile;
+    QAtomicInt mFinishedCount;
 };
 
 #endif // OJPROBLEMCASESRUNNER_H
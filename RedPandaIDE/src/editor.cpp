@@ -144,6 +144,8 @@ Editor::Editor(QWidget *parent):
     mHighlightCharPos1 = CharPos{-1,-1};
     mHighlightCharPos2 = CharPos{-1,-1};
     mCurrentLineModified = false;
+    mLastParsedRevision = 0;
+    mContentsRevision = 0;
 
     mFunctionTooltip = nullptr;
     mCompletionPopup = nullptr;
@@ -160,6 +162,15 @@ Editor::Editor(QWidget *parent):
 
     connect(this,&QSynEdit::gutterClicked,this,&Editor::onGutterClicked);
 
+    // keep cached identifier kinds with their lines until the next parse
+    connect(this,&QSynEdit::linesInserted,this,&Editor::onEditorLinesInserted);
+    connect(this,&QSynEdit::linesDeleted,this,&Editor::onEditorLinesDeleted);
+    connect(this,&QSynEdit::lineMoved,this,&Editor::onEditorLineMoved);
+
+    connect(document().get(), &QSynedit::Document::changed, this, [this](){
+        mContentsRevision++;
+    });
+
     setAttribute(Qt::WA_Hover,true);
 
     setContextMenuPolicy(Qt::CustomContextMenu);
@@ -1155,8 +1166,10 @@ void Editor::onPreparePaintHighlightToken(int line, int aChar, const QString &to
             CharPos p{aChar,line};
 
             StatementKind kind;
-            if (mParser->parsing()){
-                kind=mIdCache.value(QString("%1 %2 %3").arg(line).arg(aChar).arg(token),StatementKind::Unknown);
+            if (findCachedIdentifierKind(line, aChar, token, kind)) {
+                // resolved in a previous paint
+            } else if (mParser->parsing()){
+                kind=StatementKind::Unknown;
             } else {
                 QStringList expression = getExpressionAtPosition(p);
                 PStatement statement = parser()->findStatementOf(
@@ -1176,7 +1189,7 @@ void Editor::onPreparePaintHighlightToken(int line, int aChar, const QString &to
                     }
                 }
                 kind = getKindOfStatement(statement);
-                mIdCache.insert(QString("%1 %2 %3").arg(line).arg(aChar).arg(token),kind);
+                cacheIdentifierKind(line, aChar, token, kind);
             }
             if (kind == StatementKind::Unknown) {
                 CharPos pBeginPos,pEndPos;
@@ -1969,9 +1982,68 @@ void Editor::onTooltipTimer()
     }
 }
 
+bool Editor::findCachedIdentifierKind(int line, int aChar, const QString &token, StatementKind &kind) const
+{
+    if (line<0 || line>=mIdentifierKinds.count())
+        return false;
+    foreach (const IdentifierKind& identifierKind, mIdentifierKinds[line]) {
+        if (identifierKind.ch == aChar && identifierKind.token == token) {
+            kind = identifierKind.kind;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Editor::cacheIdentifierKind(int line, int aChar, const QString &token, StatementKind kind)
+{
+    if (line<0)
+        return;
+    if (line>=mIdentifierKinds.count())
+        mIdentifierKinds.resize(std::max(line+1, document()->count()));
+    QVector<IdentifierKind>& kinds = mIdentifierKinds[line];
+    for (IdentifierKind& identifierKind : kinds) {
+        if (identifierKind.ch == aChar) {
+            identifierKind.token = token;
+            identifierKind.kind = kind;
+            return;
+        }
+    }
+    kinds.append(IdentifierKind{aChar, token, kind});
+}
+
+void Editor::onEditorLinesInserted(int line, int count)
+{
+    if (line<0 || line>=mIdentifierKinds.count() || count<=0)
+        return;
+    mIdentifierKinds.insert(line, count, QVector<IdentifierKind>());
+}
+
+void Editor::onEditorLinesDeleted(int line, int count)
+{
+    if (line<0 || line>=mIdentifierKinds.count() || count<=0)
+        return;
+    mIdentifierKinds.remove(line, std::min(count, mIdentifierKinds.count()-line));
+}
+
+void Editor::onEditorLineMoved(int from, int to)
+{
+    if (from<0 || to<0 || from==to)
+        return;
+    if (mIdentifierKinds.isEmpty())
+        return;
+    if (std::max(from,to)>=mIdentifierKinds.count())
+        mIdentifierKinds.resize(std::max(from,to)+1);
+    mIdentifierKinds.move(from, to);
+}
+
 void Editor::onParseFinished()
 {
-    mIdCache.clear();
+    // the parser read the contents when the parsing ran, not when it was requested.
+    // If they have changed since the request, we don't know what has been parsed.
+    if (mLastParsedRevision!=mContentsRevision)
+        mLastParsedLineHashes.clear();
+    mIdentifierKinds.clear();
     invalidateAllNonTempLineWidth();
     invalidate();
 }
@@ -1991,14 +2063,25 @@ void Editor::setCppParser(PCppParser parser)
                 &CppParser::parseFinished,
                 this,
                 &Editor::onParseFinished);
+        disconnect(mParser.get(),
+                &CppParser::functionBodyReparsed,
+                this,
+                &Editor::onParseFinished);
         mParser->invalidateFile(mFilename);
     }
     mParser = parser;
+    mIdentifierKinds.clear();
+    mLastParsedLineHashes.clear();
     if (mParser) {
         connect(mParser.get(),
                 &CppParser::parseFinished,
                 this,
                 &Editor::onParseFinished);
+        // hidden editors are refreshed too, it's cheap
+        connect(mParser.get(),
+                &CppParser::functionBodyReparsed,
+                this,
+                &Editor::onParseFinished);
     }
     //todo:
 }
@@ -2450,7 +2533,7 @@ bool Editor::handleSymbolCompletion(QChar key)
         bool inNumber = false;
         if (caretX() <= 0) {
             if (caretY()>0) {
-                inComment = syntaxer()->isCommentNotFinished(document()->getSyntaxState(caretY() - 1));
+                inComment = syntaxer()->isCommentNotFinished(lineSyntaxState(caretY() - 1));
             }
         } else {
             CharPos  highlightPos = CharPos{caretX()-1, caretY()};
@@ -2941,7 +3024,39 @@ void Editor::reparse()
         return;
 //    qDebug()<<"reparse "<<mFilename;
     //mParser->setEnabled(mCodeCompletionSettings->enabled());
-    CppParser::parseFileNonBlocking(mParser,mFilename, inProject(), mContextFile);
+    QStringList contents = document()->content();
+    QVector<size_t> lineHashes;
+    lineHashes.reserve(contents.count());
+    foreach (const QString& line, contents)
+        lineHashes.append(qHash(line));
+    // editors using the parser are refreshed by its functionBodyReparsed signal
+    bool reparsed = reparseChangedFunctionBody(contents, lineHashes);
+    mLastParsedLineHashes = std::move(lineHashes);
+    mLastParsedRevision = mContentsRevision;
+    if (reparsed)
+        return;
+    CppParser::parseFileNonBlocking(mParser,mFilename, inProject(), mContextFile, false, true, hasFocus());
+}
+
+bool Editor::reparseChangedFunctionBody(const QStringList &contents, const QVector<size_t> &lineHashes)
+{
+    if (mLastParsedLineHashes.isEmpty())
+        return false;
+    int oldCount = mLastParsedLineHashes.count();
+    int newCount = lineHashes.count();
+    int first = 0;
+    while (first<newCount && first<oldCount && lineHashes[first]==mLastParsedLineHashes[first])
+        first++;
+    if (first>=newCount && first>=oldCount)
+        return false;
+    // last changed lines in the old and the new contents
+    int last = oldCount-1;
+    int newLast = newCount-1;
+    while (last>=first && newLast>=first && lineHashes[newLast]==mLastParsedLineHashes[last]) {
+        last--;
+        newLast--;
+    }
+    return mParser->reparseFunctionBody(mFilename, contents, first, last, newCount-oldCount);
 }
 
 void Editor::reparseIfNeeded()
@@ -3313,10 +3428,17 @@ void Editor::showCompletion(const QString& preWord,bool autoComplete, CodeComple
     mCompletionPopup->setKeypressedCallback([this](QKeyEvent *event)->bool{
         return onCompletionKeyPressed(event);
     });
-    mCompletionPopup->setParser(mParser);
-    if (mParser) {
+    PCppParser parser = mParser;
+    if (parser && parser->parsing()) {
+        // don't wait for the parsing, use the last published copy of the parser
+        PCppParser snapshot = parser->readSnapshot();
+        if (snapshot)
+            parser = snapshot;
+    }
+    mCompletionPopup->setParser(parser);
+    if (parser) {
         mCompletionPopup->setCurrentScope(
-                    mParser->findScopeStatement(mFilename, caretY())
+                    parser->findScopeStatement(mFilename, caretY())
                     );
     }
     if (mFunctionTooltip) mFunctionTooltip->hide();
@@ -4098,7 +4220,7 @@ void Editor::updateFunctionTip(bool showTip)
 
     // Only do the cumbersome list filling when showing a new tooltip...
     if (s != mFunctionTooltip->functionFullName()
-            && !mParser->parsing()) {
+            && (!mParser->parsing() || mParser->readSnapshot())) {
         mFunctionTooltip->clearTips();
         QList<PStatement> statements=mParser->getListOfFunctions(mFilename,
                                                                   s,
@@ -5259,6 +5381,7 @@ void Editor::applySettings()
             | QSynedit::EditorOption::RightMouseMovesCursor
             | QSynedit::EditorOption::TabIndent
             | QSynedit::EditorOption::GroupUndo
+            | QSynedit::EditorOption::MergeInputUndo
             | QSynedit::EditorOption::SelectWordByDblClick;
 
     //options
@@ -5362,6 +5485,7 @@ void Editor::applySettings()
         }
 #endif
         ((QSynedit::CppSyntaxer*)(syntaxer().get()))->setCustomTypeKeywords(set);
+        invalidateTokens();
     }
 
     mCodeCompletionEnabled = mCodeCompletionSettings && mCodeCompletionSettings->enabled();
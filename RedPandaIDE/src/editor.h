@@ -365,12 +365,16 @@ private slots:
     void onAutoBackupTimer();
     void onTooltipTimer();
     void onParseFinished();
+    void onEditorLinesInserted(int line, int count);
+    void onEditorLinesDeleted(int line, int count);
+    void onEditorLineMoved(int from, int to);
 
 private:
     bool completionPopupVisible() const;
     bool headerCompletionPopupVisible() const;
     bool functionTooltipVisible() const;
     void loadContent(const QString& filename);
+    bool reparseChangedFunctionBody(const QStringList& contents, const QVector<size_t>& lineHashes);
     bool isBraceChar(QChar ch) const;
     bool shouldOpenInReadonly();
     QChar getCurrentChar();
@@ -481,6 +485,9 @@ private:
 
     bool mSaving;
     bool mCurrentLineModified;
+    QVector<size_t> mLastParsedLineHashes; // line hashes when the last reparse is requested, empty if unknown
+    size_t mLastParsedRevision; // contents revision when the last reparse is requested
+    size_t mContentsRevision; // increased each time the contents are changed
     int mXOffsetSince;
     int mTabStopBegin;
     int mTabStopEnd;
@@ -501,7 +508,13 @@ private:
     FileType mFileType;
     QString mContextFile;
 
-    QMap<QString,StatementKind> mIdCache;
+    // kinds of identifiers painted since the last parse, indexed by line
+    struct IdentifierKind {
+        int ch;
+        QString token;
+        StatementKind kind;
+    };
+    QVector<QVector<IdentifierKind>> mIdentifierKinds;
     qint64 mLastFocusOutTime;
 
     CodeSnippetsManager *mCodeSnippetsManager;
@@ -531,6 +544,8 @@ protected:
     void onGetEditingAreas(int Line, QSynedit::EditingAreaList &areaList) override;
     bool onGetSpecialLineColors(int Line, QColor &foreground, QColor &backgroundColor) override;
     void onPreparePaintHighlightToken(int line, int aChar, const QString &token, QSynedit::PTokenAttribute attr, QSynedit::FontStyles &style, QColor &foreground, QColor &background) override;
+    bool findCachedIdentifierKind(int line, int aChar, const QString &token, StatementKind &kind) const;
+    void cacheIdentifierKind(int line, int aChar, const QString &token, StatementKind kind);
 
     // QObject interface
 public:
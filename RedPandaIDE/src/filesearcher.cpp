@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "filesearcher.h"
+#include <QDir>
+#include <QFont>
+#include <QRunnable>
+#include <QSet>
+#include <QStack>
+#include <QThreadPool>
+#include <qsynedit/document.h>
+#include <qsynedit/searcher/basicsearcher.h>
+#include <qsynedit/searcher/regexsearcher.h>
+#include "systemconsts.h"
+
+namespace {
+
+bool isWordBorder(const QString& line, int pos)
+{
+    if (pos<=0 || pos>=line.length())
+        return true;
+    auto isWordChar = [](const QChar& ch) {
+        return ch == '_' || ch.isLetterOrNumber();
+    };
+    return !isWordChar(line[pos-1]) || !isWordChar(line[pos]);
+}
+
+class FileSearchTask : public QRunnable
+{
+public:
+    FileSearchTask(const QString& filename,
+                   const QByteArray& encoding,
+                   const QStringList* openedContent,
+                   const QString& keyword,
+                   QSynedit::SearchOptions options,
+                   bool useRegex,
+                   const QAtomicInt& canceled):
+        mFilename{filename},
+        mEncoding{encoding},
+        mOpenedContent{openedContent},
+        mKeyword{keyword},
+        mOptions{options},
+        mUseRegex{useRegex},
+        mCanceled{canceled},
+        mSearched{false}
+    {
+        setAutoDelete(false);
+    }
+
+    PSearchResultTreeItem result() const { return mResult; }
+    bool searched() const { return mSearched; }
+
+    void run() override {
+        if (mCanceled.loadRelaxed())
+            return;
+        QStringList lines;
+        if (mOpenedContent) {
+            lines = *mOpenedContent;
+        } else {
+            // load by a document instead of an editor widget, to share its encoding detection
+            QSynedit::Document document{QFont{}};
+            QByteArray realEncoding;
+            try {
+                document.loadFromFile(mFilename, mEncoding, realEncoding);
+            } catch (FileError&) {
+                return;
+            }
+            lines = document.content();
+        }
+        mSearched = true;
+
+        QSynedit::PSearcher searcher;
+        if (mUseRegex)
+            searcher = std::make_shared<QSynedit::RegexSearcher>();
+        else
+            searcher = std::make_shared<QSynedit::BasicSearcher>();
+        searcher->setOptions(mOptions);
+        searcher->setPattern(mKeyword);
+
+        mResult = std::make_shared<SearchResultTreeItem>();
+        mResult->filename = mFilename;
+        mResult->parent = nullptr;
+        mResult->selected = false;
+        for (int i=0;i<lines.count();i++) {
+            if (i % 1024 == 0 && mCanceled.loadRelaxed())
+                return;
+            const QString& line = lines[i];
+            int count = searcher->findAll(line);
+            for (int j=0;j<count;j++) {
+                int start = searcher->result(j);
+                int len = searcher->length(j);
+                if (mOptions.testFlag(QSynedit::ssoWholeWord) && len>0) {
+                    if (!isWordBorder(line, start) || !isWordBorder(line, start+len))
+                        continue;
+                }
+                PSearchResultTreeItem item = std::make_shared<SearchResultTreeItem>();
+                item->filename = mFilename;
+                item->line = i;
+                item->start = start;
+                item->len = len;
+                item->parent = mResult.get();
+                item->text = line;
+                item->text.replace('\t',' ');
+                item->selected = true;
+                mResult->results.append(item);
+            }
+        }
+    }
+private:
+    QString mFilename;
+    QByteArray mEncoding;
+    const QStringList* mOpenedContent;
+    QString mKeyword;
+    QSynedit::SearchOptions mOptions;
+    bool mUseRegex;
+    const QAtomicInt& mCanceled;
+    bool mSearched;
+    PSearchResultTreeItem mResult;
+};
+
+}
+
+FileSearchThread::FileSearchThread(const QString &keyword, QSynedit::SearchOptions options,
+                                   bool useRegex, QObject *parent):
+    QThread{parent},
+    mKeyword{keyword},
+    mOptions{options},
+    mUseRegex{useRegex},
+    mSearchFolder{false},
+    mSearchSubfolders{true},
+    mCanceled{0}
+{
+}
+
+void FileSearchThread::setFiles(const QStringList &files, const QHash<QString, QByteArray> &encodings)
+{
+    mSearchFolder = false;
+    mFiles = files;
+    mEncodings = encodings;
+}
+
+void FileSearchThread::setFolder(const QString &folder, const QStringList &filters, bool searchSubfolders)
+{
+    mSearchFolder = true;
+    mFolder = folder;
+    mFilters = filters;
+    mSearchSubfolders = searchSubfolders;
+}
+
+void FileSearchThread::setOpenedFileContents(const QHash<QString, QStringList> &contents)
+{
+    mOpenedFileContents = contents;
+}
+
+void FileSearchThread::cancel()
+{
+    mCanceled.storeRelaxed(1);
+}
+
+bool FileSearchThread::isCanceled() const
+{
+    return mCanceled.loadRelaxed();
+}
+
+QStringList FileSearchThread::collectFilesInFolder() const
+{
+    QStringList files;
+    QStack<QDir> dirs;
+    QSet<QString> searched;
+    dirs.push(QDir(mFolder));
+    QDir::Filters filterOptions=QDir::Files | QDir::NoSymLinks;
+    if (PATH_SENSITIVITY==Qt::CaseSensitive)
+        filterOptions |= QDir::CaseSensitive;
+    while (!dirs.isEmpty() && !isCanceled()) {
+        QDir dir=dirs.back();
+        dirs.pop_back();
+        if (mSearchSubfolders) {
+            foreach(const QFileInfo& entry, dir.entryInfoList(QDir::NoSymLinks | QDir::Dirs | QDir::NoDotAndDotDot)) {
+                if (!searched.contains(entry.absoluteFilePath())) {
+                    dirs.push_back(QDir(entry.absoluteFilePath()));
+                    searched.insert(entry.absoluteFilePath());
+                }
+            }
+        }
+        foreach(const QFileInfo& entry, dir.entryInfoList(mFilters, filterOptions)) {
+            files.append(entry.absoluteFilePath());
+        }
+    }
+    return files;
+}
+
+void FileSearchThread::run()
+{
+    QStringList files = mSearchFolder ? collectFilesInFolder() : mFiles;
+    emit filesCollected(files.count());
+
+    QThreadPool pool;
+    // search a batch of files in parallel, then report them in order
+    int batchSize = std::max(1, QThread::idealThreadCount()) * 4;
+    int filesSearched = 0;
+    int filesHitted = 0;
+    for (int start=0; start<files.count() && !isCanceled(); start+=batchSize) {
+        int end = std::min(start+batchSize, (int)files.count());
+        QList<std::shared_ptr<FileSearchTask>> tasks;
+        for (int i=start;i<end;i++) {
+            const QString& filename = files[i];
+            auto it = mOpenedFileContents.constFind(filename);
+            auto task = std::make_shared<FileSearchTask>(
+                        filename,
+                        mEncodings.value(filename, ENCODING_AUTO_DETECT),
+                        it!=mOpenedFileContents.constEnd()?&it.value():nullptr,
+                        mKeyword, mOptions, mUseRegex, mCanceled);
+            tasks.append(task);
+            pool.start(task.get());
+        }
+        pool.waitForDone();
+        for (int i=0;i<tasks.count();i++) {
+            if (isCanceled())
+                break;
+            const std::shared_ptr<FileSearchTask>& task = tasks[i];
+            emit searchingFile(files[start+i], start+i+1);
+            if (!task->searched())
+                continue;
+            filesSearched++;
+            if (task->result() && !task->result()->results.isEmpty()) {
+                filesHitted++;
+                emit fileSearched(task->result());
+            }
+        }
+    }
+    emit searchFinished(filesSearched, filesHitted);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FILESEARCHER_H
+#define FILESEARCHER_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QThread>
+#include "widgets/searchresultview.h"
+
+/**
+ * @brief Searches files for a keyword in the background.
+ *
+ * Files are loaded without editor widgets and searched in parallel.
+ * Contents of opened editors are searched instead of the files on disk.
+ */
+class FileSearchThread: public QThread
+{
+    Q_OBJECT
+public:
+    explicit FileSearchThread(const QString& keyword, QSynedit::SearchOptions options,
+                              bool useRegex, QObject* parent = nullptr);
+    // search the files, using the encoding given for each file (auto detect if not given)
+    void setFiles(const QStringList& files, const QHash<QString,QByteArray>& encodings = QHash<QString,QByteArray>());
+    // search files matching the filters in the folder
+    void setFolder(const QString& folder, const QStringList& filters, bool searchSubfolders);
+    void setOpenedFileContents(const QHash<QString,QStringList>& contents);
+    void cancel();
+    bool isCanceled() const;
+signals:
+    void filesCollected(int count);
+    void searchingFile(const QString& filename, int index);
+    void fileSearched(PSearchResultTreeItem fileItem);
+    void searchFinished(int filesSearched, int filesHitted);
+private:
+    QStringList collectFilesInFolder() const;
+private:
+    QString mKeyword;
+    QSynedit::SearchOptions mOptions;
+    bool mUseRegex;
+    QStringList mFiles;
+    QHash<QString,QByteArray> mEncodings;
+    bool mSearchFolder;
+    QString mFolder;
+    QStringList mFilters;
+    bool mSearchSubfolders;
+    QHash<QString,QStringList> mOpenedFileContents;
+    QAtomicInt mCanceled;
+
+    // QThread interface
+protected:
+    void run() override;
+};
+
+#endif // FILESEARCHER_H
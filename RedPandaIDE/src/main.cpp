@@ -339,8 +339,10 @@ int main(int argc, char *argv[])
     qRegisterMetaType<POJProblem>("POJProblem");
     qRegisterMetaType<PCompileIssue>("PCompileIssue");
     qRegisterMetaType<PCompileIssue>("PCompileIssue&");
+    qRegisterMetaType<QVector<PCompileIssue>>("QVector<PCompileIssue>");
     qRegisterMetaType<QVector<int>>("QVector<int>");
     qRegisterMetaType<QHash<int,QString>>("QHash<int,QString>");
+    qRegisterMetaType<PSearchResultTreeItem>("PSearchResultTreeItem");
 
     initParser();
 
@@ -6083,31 +6083,45 @@ void MainWindow::logToolsOutput(const QString& msg)
     ui->txtToolsOutput->ensureCursorVisible();
 }
 
-void MainWindow::onCompileIssue(PCompileIssue issue)
-{
-    if (issue->filename.isEmpty())
-        return;
-    if (issue->filename.contains("*"))
-        return;
-    ui->tableIssues->addIssue(issue);
-
-    if (issue->type == CompileIssueType::Error || issue->type ==
-            CompileIssueType::Warning) {
-        Editor* e = mEditorManager->getOpenedEditor(issue->filename);
-        if (e!=nullptr && (issue->line>=0)) {
-            int line = issue->line;
-            if (line >= e->lineCount()) {
+void MainWindow::onCompileIssues(QVector<PCompileIssue> issues)
+{
+    QVector<PCompileIssue> shownIssues;
+    shownIssues.reserve(issues.count());
+    QHash<QString, Editor*> editors;
+    QSet<Editor*> changedEditors;
+    foreach (const PCompileIssue& issue, issues) {
+        if (issue->filename.isEmpty())
+            continue;
+        if (issue->filename.contains("*"))
+            continue;
+        shownIssues.append(issue);
+
+        if (issue->type == CompileIssueType::Error || issue->type ==
+                CompileIssueType::Warning) {
+            auto it = editors.find(issue->filename);
+            if (it == editors.end())
+                it = editors.insert(issue->filename, mEditorManager->getOpenedEditor(issue->filename));
+            Editor* e = it.value();
+            if (e!=nullptr && (issue->line>=0)) {
+                int line = issue->line;
+                if (line >= e->lineCount()) {
 #ifdef QT_DEBUG
-                qDebug()<<issue->line<<issue->description;
+                    qDebug()<<issue->line<<issue->description;
 #endif
-                return;
+                    continue;
+                }
+                int col = std::min(issue->column,e->lineText(line).length());
+                if (col < 0)
+                    col = e->lineText(line).length();
+                e->addSyntaxIssues(line,col,issue->endColumn,issue->type,issue->description);
+                changedEditors.insert(e);
             }
-            int col = std::min(issue->column,e->lineText(line).length());
-            if (col < 0)
-                col = e->lineText(line).length();
-            e->addSyntaxIssues(line,col,issue->endColumn,issue->type,issue->description);
         }
     }
+    ui->tableIssues->addIssues(shownIssues);
+    // repaint each editor once for the whole batch
+    foreach (Editor* e, changedEditors)
+        e->invalidate();
 }
 
 void MainWindow::clearToolsOutput()
@@ -6362,6 +6376,10 @@ void MainWindow::onOJProblemCaseStarted(const QString& id,int current, int total
         problemCase->testState = ProblemCaseTestState::Testing;
         mOJProblemModel->update(row);
         QModelIndex idx = ui->tblProblemCases->currentIndex();
+        // cases may run in parallel, keep showing the output of the case being tested
+        if (idx.isValid() && row != idx.row()
+                && mOJProblemModel->getCase(idx.row())->testState == ProblemCaseTestState::Testing)
+            return;
         if (!idx.isValid() || row != idx.row()) {
             ui->tblProblemCases->setCurrentIndex(mOJProblemModel->index(row,0));
         }
@@ -6382,20 +6400,25 @@ void MainWindow::onOJProblemCaseFinished(const QString& id, int current, int tot
                     ProblemCaseTestState::Passed:
                     ProblemCaseTestState::Failed;
         mOJProblemModel->update(row);
-        updateProblemCaseOutput(problemCase);
+        if (isCurrentProblemCase(id))
+            updateProblemCaseOutput(problemCase);
     }
     ui->pbProblemCases->setMaximum(total);
     ui->pbProblemCases->setValue(current);
     updateProblemTitle();
 }
 
-void MainWindow::onOJProblemCaseNewOutputGetted(const QString &/* id */, const QString &line)
+void MainWindow::onOJProblemCaseNewOutputGetted(const QString &id, const QString &line)
 {
+    if (!isCurrentProblemCase(id))
+        return;
     ui->txtProblemCaseOutput->appendPlainText(line);
 }
 
-void MainWindow::onOJProblemCaseResetOutput(const QString &/* id */, const QString &line)
+void MainWindow::onOJProblemCaseResetOutput(const QString &id, const QString &line)
 {
+    if (!isCurrentProblemCase(id))
+        return;
     ui->txtProblemCaseOutput->clearAll();
     ui->txtProblemCaseOutput->setPlainText(line);
 }
@@ -8621,7 +8644,16 @@ void MainWindow::updateProblemCaseOutput(POJProblemCase problemCase)
         } else
             return;
         if (diffLine < problemCase->outputLineCounts) {
-            ui->txtProblemCaseOutput->highlightLine(diffLine, mErrorColor);
+            int outputLine = diffLine;
+            if (problemCase->outputHeadLineCounts>=0 && diffLine>=problemCase->outputHeadLineCounts) {
+                // the output is a preview, map the line to its tail, or to the omission mark
+                int tailStart = problemCase->outputLineCounts - problemCase->outputTailLineCounts;
+                if (diffLine >= tailStart)
+                    outputLine = problemCase->outputHeadLineCounts + 1 + diffLine - tailStart;
+                else
+                    outputLine = problemCase->outputHeadLineCounts;
+            }
+            ui->txtProblemCaseOutput->highlightLine(outputLine, mErrorColor);
         } else {
             ui->txtProblemCaseOutput->moveCursor(QTextCursor::MoveOperation::End);
             ui->txtProblemCaseOutput->moveCursor(QTextCursor::MoveOperation::StartOfLine);
@@ -8642,6 +8674,15 @@ void MainWindow::updateProblemCaseOutput(POJProblemCase problemCase)
     }
 }
 
+bool MainWindow::isCurrentProblemCase(const QString &id)
+{
+    QModelIndex idx = ui->tblProblemCases->currentIndex();
+    if (!idx.isValid())
+        return false;
+    POJProblemCase problemCase = mOJProblemModel->getCase(idx.row());
+    return problemCase && problemCase->id() == id;
+}
+
 void MainWindow::applyCurrentProblemCaseChanges()
 {
     QModelIndex idx = ui->tblProblemCases->currentIndex();
@@ -235,7 +235,7 @@ public:
 
 public slots:
     void logToolsOutput(const QString& msg);
-    void onCompileIssue(PCompileIssue issue);
+    void onCompileIssues(QVector<PCompileIssue> issues);
     void clearToolsOutput();
     void clearTodos();
     void onCompileStarted();
@@ -322,6 +322,7 @@ private:
     void doGenerateGimple();
     void doGeneratePreprocessed();
     void updateProblemCaseOutput(POJProblemCase problemCase);
+    bool isCurrentProblemCase(const QString& id);
     void applyCurrentProblemCaseChanges();
     void showHideInfosTab(QWidget *widget, bool show);
     void showHideMessagesTab(QWidget *widget, bool show);
@@ -19,11 +19,18 @@
 #include "qsynedit/syntaxer/cpp.h"
 #include <qt_utils/utils.h>
 #include <QApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDate>
+#include <QFile>
+#include <QFileInfo>
 #include <QHash>
 #include <QQueue>
 #include <QRegularExpression>
+#include <QRunnable>
+#include <QSaveFile>
 #include <QThread>
+#include <QThreadPool>
 #include <QTime>
 
 //Enable debug log
@@ -65,9 +72,15 @@ CppParser::CppParser() : QObject{nullptr},
     //mSkipList;
     mSharedByFiles = false;
     mLockCount = 0;
+    mParseJobScheduled = false;
+    mStopParse = false;
+    mReadSnapshotWanted = false;
+    mReadSnapshotOutdated = false;
     mIsSystemHeader = false;
     mIsHeader = false;
     mIsProjectFile = false;
+    mCachedSystemHeadersCount = 0;
+    mSavedSystemHeaderScanCount = 0;
 
     mCppKeywords = CppKeywords;
     mCppTypeKeywords = CppTypeKeywords;
@@ -150,8 +163,13 @@ QList<PStatement> CppParser::getListOfFunctions(const QString &fileName, const Q
 {
     QMutexLocker locker(&mMutex);
     QList<PStatement> result;
-    if (mParsing)
+    if (mParsing) {
+        // don't wait for the parsing, use the last published copy
+        PCppParser snapshot = doGetReadSnapshot();
+        if (snapshot)
+            result = snapshot->getListOfFunctions(fileName, phrase, line);
         return result;
+    }
 
     QStringList expression = splitExpression(phrase);
     PStatement statement = doFindStatementOf(fileName, expression, line);
@@ -193,7 +211,8 @@ PStatement CppParser::findScopeStatement(const QString &filename, int line) cons
 {
     QMutexLocker locker(&mMutex);
     if (mParsing) {
-        return PStatement();
+        PCppParser snapshot = doGetReadSnapshot();
+        return snapshot?snapshot->findScopeStatement(filename, line):PStatement();
     }
     return doFindScopeStatement(filename,line);
 }
@@ -316,8 +335,10 @@ PStatement CppParser::doFindStatement(const QString &fullname) const
 PStatement CppParser::findStatementOf(const QString &fileName, const QString &phrase, int line) const
 {
     QMutexLocker locker(&mMutex);
-    if (mParsing)
-        return PStatement();
+    if (mParsing) {
+        PCppParser snapshot = doGetReadSnapshot();
+        return snapshot?snapshot->findStatementOf(fileName, phrase, line):PStatement();
+    }
     return doFindStatementOf(fileName,phrase,line);
 }
 PStatement CppParser::doFindStatementOf(const QString &fileName, const QString &phrase, int line) const
@@ -331,8 +352,10 @@ PStatement CppParser::findStatementOf(const QString &fileName,
                                       PStatement &parentScopeType) const
 {
     QMutexLocker locker(&mMutex);
-    if (mParsing)
-        return PStatement();
+    if (mParsing) {
+        PCppParser snapshot = doGetReadSnapshot();
+        return snapshot?snapshot->findStatementOf(fileName, phrase, currentScope, parentScopeType):PStatement();
+    }
     return doFindStatementOf(fileName,phrase,currentScope,parentScopeType);
 }
 
@@ -503,8 +526,10 @@ PEvalStatement CppParser::evalExpression(
         const PStatement &currentScope) const
 {
     QMutexLocker locker(&mMutex);
-    if (mParsing)
-        return PEvalStatement();
+    if (mParsing) {
+        PCppParser snapshot = doGetReadSnapshot();
+        return snapshot?snapshot->evalExpression(fileName, phraseExpression, currentScope):PEvalStatement();
+    }
 //    qDebug()<<phraseExpression;
     int pos = 0;
     return doEvalExpression(fileName,
@@ -526,8 +551,10 @@ PStatement CppParser::doFindStatementOf(const QString &fileName, const QString &
 PStatement CppParser::findStatementOf(const QString &fileName, const QStringList &expression, const PStatement &currentScope) const
 {
     QMutexLocker locker(&mMutex);
-    if (mParsing)
-        return PStatement();
+    if (mParsing) {
+        PCppParser snapshot = doGetReadSnapshot();
+        return snapshot?snapshot->findStatementOf(fileName, expression, currentScope):PStatement();
+    }
     return doFindStatementOf(fileName,expression,currentScope);
 }
 
@@ -596,8 +623,10 @@ PStatement CppParser::doFindStatementOf(const QString &fileName, const QStringLi
 PStatement CppParser::findStatementOf(const QString &fileName, const QStringList &expression, int line) const
 {
     QMutexLocker locker(&mMutex);
-    if (mParsing)
-        return PStatement();
+    if (mParsing) {
+        PCppParser snapshot = doGetReadSnapshot();
+        return snapshot?snapshot->findStatementOf(fileName, expression, line):PStatement();
+    }
     return doFindStatementOf(fileName,expression,line);
 }
 
@@ -995,14 +1024,30 @@ void CppParser::invalidateFile(const QString &fileName)
         return;
     {
         QMutexLocker locker(&mMutex);
-        if (mParsing || mLockCount>0)
+        if (mParsing || mLockCount>0) {
+            // invalidate it after the current parsing is finished / the parser is unfrozen
+            PParseFileCommand command = std::make_shared<ParseFileCommand>();
+            command->fileName = fileName;
+            command->inProject = false;
+            command->onlyIfNotParsed = false;
+            command->updateView = false;
+            command->fileList = false;
+            command->invalidateOnly = true;
+            command->highPriority = false;
+            enqueueParseCommand(std::move(command));
             return;
+        }
         updateSerialId();
         mParsing = true;
+        retireReadSnapshot();
     }
     QSet<QString> files = calculateFilesToBeReparsed(fileName);
     internalInvalidateFiles(files);
-    mParsing = false;
+    {
+        QMutexLocker locker(&mMutex);
+        mParsing = false;
+    }
+    schedulePendingParseCommands();
 }
 
 bool CppParser::isIncludeLine(const QString &line) const
@@ -1046,18 +1091,24 @@ bool CppParser::parseFile(const QString &fileName, bool inProject,
         return false;
     {
         QMutexLocker locker(&mMutex);
-        if (mParsing) {
-            mLastParseFileCommand = std::make_unique<ParseFileCommand>();
-            mLastParseFileCommand->fileName = fileName;
-            mLastParseFileCommand->inProject = inProject;
-            mLastParseFileCommand->contextFilename = contextFilename;
-            mLastParseFileCommand->onlyIfNotParsed = onlyIfNotParsed;
-            mLastParseFileCommand->updateView = updateView;
+        if (mParsing || mLockCount>0) {
+            // parse it after the current parsing is finished / the parser is unfrozen
+            PParseFileCommand command = std::make_shared<ParseFileCommand>();
+            command->fileName = fileName;
+            command->inProject = inProject;
+            command->contextFilename = contextFilename;
+            command->onlyIfNotParsed = onlyIfNotParsed;
+            command->updateView = updateView;
+            command->fileList = false;
+            command->invalidateOnly = false;
+            command->highPriority = false;
+            enqueueParseCommand(std::move(command));
             return false;
         }
-        if (mLockCount>0)
-            return false;
         mParsing = true;
+        mStopParse = false;
+        mParsingFileName = fileName;
+        retireReadSnapshot();
         updateSerialId();
         if (updateView)
             emit onBusy();
@@ -1071,6 +1122,8 @@ bool CppParser::parseFile(const QString &fileName, bool inProject,
             else
                 emit parseFinished(mFilesScannedCount,0);
             mParsing = false;
+            mParsingFileName.clear();
+            schedulePendingParseCommands();
         });
         QString fName = fileName;
         if (onlyIfNotParsed && mPreprocessor.fileScanned(fName))
@@ -1084,13 +1137,10 @@ bool CppParser::parseFile(const QString &fileName, bool inProject,
             mFilesToScanCount = files.count();
             mFilesScannedCount = 0;
 
-            foreach (const QString& file,files) {
-                mFilesScannedCount++;
-                emit progress(file,mFilesToScanCount,mFilesScannedCount);
-                if (!mPreprocessor.fileScanned(file)) {
-                    internalParse(file);
-                }
-            }
+            internalParseFiles(files);
+            // files skipped by the stopped parsing are added to the files to scan
+            if (mStopParse)
+                enqueueFileListCommand(false);
         } else {
             internalInvalidateFile(fileName);
             internalInvalidateFile(contextFilename);
@@ -1100,10 +1150,14 @@ bool CppParser::parseFile(const QString &fileName, bool inProject,
             mFilesScannedCount++;
             emit progress(fileName,mFilesToScanCount,mFilesScannedCount);
             internalParse(contextFilename);
-            if (!mPreprocessor.fileScanned(fileName)) {
+            if (!mStopParse && !mPreprocessor.fileScanned(fileName)) {
                 internalParse(fileName);
             }
         }
+        // don't check the cacheable headers after each edit, only when system headers are scanned
+        if (mPreprocessor.systemHeaderScanCount()!=mSavedSystemHeaderScanCount)
+            saveSystemHeaderCache();
+        publishReadSnapshot();
     }
     return true;
 }
@@ -1114,43 +1168,140 @@ void CppParser::parseFileList(bool updateView)
         return;
     {
         QMutexLocker locker(&mMutex);
-        if (mParsing || mLockCount>0)
+        if (mParsing || mLockCount>0) {
+            // we may be called by a parse job, don't lose its command
+            enqueueFileListCommand(updateView);
             return;
+        }
         updateSerialId();
         mParsing = true;
+        mStopParse = false;
+        retireReadSnapshot();
         if (updateView)
             emit onBusy();
         emit parseStarted();
     }
     {
         auto action = finally([&,this]{
+            QMutexLocker locker(&mMutex);
             mParsing = false;
             if (updateView)
                 emit parseFinished(mFilesScannedCount,1);
             else
                 emit parseFinished(mFilesScannedCount,0);
+            schedulePendingParseCommands();
         });
         // Support stopping of parsing when files closes unexpectedly
         mFilesScannedCount = 0;
         mFilesToScanCount = mFilesToScan.count();
 
         QStringList files = sortFilesByIncludeRelations(mFilesToScan);
+        // files not parsed (if the parsing is stopped) are added back by internalParseFiles()
+        mFilesToScan.clear();
         // parse header files in the first parse
-        foreach (const QString& file, files) {
-            mFilesScannedCount++;
-            emit progress(mCurrentFile,mFilesToScanCount,mFilesScannedCount);
-            if (!mPreprocessor.fileScanned(file)) {
-                internalParse(file);
-            }
+        internalParseFiles(files);
+        saveSystemHeaderCache();
+        publishReadSnapshot();
+    }
+}
+
+void CppParser::enqueueParseCommand(PParseFileCommand command)
+{
+    QMutexLocker locker(&mMutex);
+    // an older command for the same file is stale, replace it
+    for (int i=0;i<mPendingParseCommands.count();i++) {
+        const PParseFileCommand& oldCommand = mPendingParseCommands[i];
+        if (oldCommand->fileList == command->fileList
+                && oldCommand->invalidateOnly == command->invalidateOnly
+                && (command->fileList || oldCommand->fileName == command->fileName)) {
+            command->highPriority = command->highPriority || oldCommand->highPriority;
+            mPendingParseCommands.removeAt(i);
+            break;
         }
-        mFilesToScan.clear();
     }
+    // the running parsing of the same file is stale too
+    if (mParsing && !command->fileList && !command->invalidateOnly && !command->onlyIfNotParsed
+            && command->fileName == mParsingFileName)
+        mStopParse = true;
+    int pos = mPendingParseCommands.count();
+    if (command->highPriority) {
+        pos = 0;
+        while (pos<mPendingParseCommands.count() && mPendingParseCommands[pos]->highPriority)
+            pos++;
+    }
+    mPendingParseCommands.insert(pos, std::move(command));
+}
+
+void CppParser::enqueueFileListCommand(bool updateView)
+{
+    PParseFileCommand command = std::make_shared<ParseFileCommand>();
+    command->inProject = true;
+    command->onlyIfNotParsed = false;
+    command->updateView = updateView;
+    command->fileList = true;
+    command->invalidateOnly = false;
+    command->highPriority = false;
+    enqueueParseCommand(std::move(command));
+}
+
+CppParser::PParseFileCommand CppParser::takePendingParseCommand()
+{
+    QMutexLocker locker(&mMutex);
+    if (mPendingParseCommands.isEmpty() || mParsing || mLockCount>0) {
+        // the job ends, it will be rescheduled when parsing is finished / the parser is unfrozen
+        mParseJobScheduled = false;
+        return PParseFileCommand();
+    }
+    return mPendingParseCommands.takeFirst();
+}
+
+class CppParseJob : public QRunnable {
+public:
+    explicit CppParseJob(const PCppParser& parser): mParser{parser} {}
+    void run() override {
+        CppParser::PParseFileCommand command;
+        while ( (command = mParser->takePendingParseCommand()) != nullptr) {
+            if (command->fileList)
+                mParser->parseFileList(command->updateView);
+            else if (command->invalidateOnly)
+                mParser->invalidateFile(command->fileName);
+            else
+                mParser->parseFile(command->fileName,
+                                   command->inProject,
+                                   command->contextFilename,
+                                   command->onlyIfNotParsed,
+                                   command->updateView);
+        }
+    }
+private:
+    PCppParser mParser;
+};
+
+class CppParseThreadPool : public QThreadPool {
+public:
+    CppParseThreadPool() {
+        // parse jobs of all parsers share a bounded number of threads
+        setMaxThreadCount(std::max(2, QThread::idealThreadCount()/2));
+    }
+};
+
+static QThreadPool* parserThreadPool()
+{
+    static CppParseThreadPool pool;
+    return &pool;
 }
 
-CppParser::PParseFileCommand CppParser::retrievePendingParseFileCommand()
+void CppParser::schedulePendingParseCommands()
 {
     QMutexLocker locker(&mMutex);
-    return std::move(mLastParseFileCommand);
+    if (mParseJobScheduled || mPendingParseCommands.isEmpty()
+            || mParsing || mLockCount>0)
+        return;
+    PCppParser parser = weak_from_this().lock();
+    if (!parser)
+        return;
+    mParseJobScheduled = true;
+    parserThreadPool()->start(new CppParseJob(parser));
 }
 
 void CppParser::parseHardDefines()
@@ -1184,6 +1335,420 @@ void CppParser::parseHardDefines()
     }
 }
 
+static constexpr quint32 SystemHeaderCacheMagic = 0x52504843; // "RPHC"
+static constexpr qint32 SystemHeaderCacheVersion = 1;
+
+static void writeDefine(QDataStream &out, const PDefine &define)
+{
+    out<<define->name<<define->args<<define->value<<define->filename
+      <<define->hardCoded<<define->argUsed<<define->argNotExpand
+      <<(qint32)define->varArgIndex<<define->formatValue;
+}
+
+static PDefine readDefine(QDataStream &in)
+{
+    PDefine define = std::make_shared<Define>();
+    qint32 varArgIndex;
+    in>>define->name>>define->args>>define->value>>define->filename
+      >>define->hardCoded>>define->argUsed>>define->argNotExpand
+      >>varArgIndex>>define->formatValue;
+    define->varArgIndex = varArgIndex;
+    return define;
+}
+
+static void writeDefineMap(QDataStream &out, const PDefineMap &defineMap)
+{
+    if (!defineMap) {
+        out<<(qint32)0;
+        return;
+    }
+    out<<(qint32)defineMap->count();
+    foreach (const PDefine& define, *defineMap) {
+        writeDefine(out, define);
+    }
+}
+
+static PDefineMap readDefineMap(QDataStream &in)
+{
+    qint32 count;
+    in>>count;
+    if (count<=0)
+        return PDefineMap();
+    PDefineMap defineMap = std::make_shared<DefineMap>();
+    for (int i=0;i<count;i++) {
+        PDefine define = readDefine(in);
+        defineMap->insert(define->name, define);
+    }
+    return defineMap;
+}
+
+QString CppParser::systemHeaderCacheKey() const
+{
+    QMutexLocker locker(&mMutex);
+    QStringList defines;
+    foreach (const PDefine& define, mPreprocessor.hardDefines()) {
+        defines.append(QString("%1%2 %3").arg(define->name,define->args,define->value));
+    }
+    defines.sort();
+    QString s = QString("%1\n%2\n%3\n%4")
+            .arg(SystemHeaderCacheVersion)
+            .arg((int)mLanguage)
+            .arg(mPreprocessor.includePathList().join("\n"),
+                 defines.join("\n"));
+    return QString::fromLatin1(
+                QCryptographicHash::hash(s.toUtf8(),QCryptographicHash::Sha1).toHex());
+}
+
+const QString &CppParser::systemHeaderCacheFile() const
+{
+    return mSystemHeaderCacheFile;
+}
+
+void CppParser::setSystemHeaderCacheFile(const QString &newSystemHeaderCacheFile)
+{
+    QMutexLocker locker(&mMutex);
+    mSystemHeaderCacheFile = newSystemHeaderCacheFile;
+}
+
+static PSystemHeaderSnapshot readSystemHeaderSnapshot(const QString& cacheFile, const QString& key)
+{
+    QFile file(cacheFile);
+    if (!file.open(QFile::ReadOnly))
+        return PSystemHeaderSnapshot();
+    qint64 size = file.size();
+    uchar* mapped = file.map(0, size);
+    QByteArray content = mapped ? QByteArray::fromRawData((const char*)mapped, size) : file.readAll();
+    QDataStream in(content);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic;
+    qint32 version;
+    QString cacheKey;
+    in>>magic>>version>>cacheKey;
+    if (magic!=SystemHeaderCacheMagic
+            || version!=SystemHeaderCacheVersion
+            || cacheKey!=key)
+        return PSystemHeaderSnapshot();
+
+    std::shared_ptr<SystemHeaderSnapshot> snapshot = std::make_shared<SystemHeaderSnapshot>();
+    snapshot->cacheFileLastModified = QFileInfo(cacheFile).lastModified().toMSecsSinceEpoch();
+    // files, stop if any of them has been modified since the cache is generated
+    qint32 fileCount;
+    in>>fileCount;
+    for (int i=0;i<fileCount;i++) {
+        QString fileName;
+        qint64 lastModified;
+        in>>fileName>>lastModified;
+        QFileInfo info(fileName);
+        if (!info.exists() || info.lastModified().toMSecsSinceEpoch()!=lastModified)
+            return PSystemHeaderSnapshot();
+        snapshot->files.append(fileName);
+        snapshot->lastModifieds.append(lastModified);
+    }
+    if (in.status()!=QDataStream::Ok)
+        return PSystemHeaderSnapshot();
+
+    qint32 uniqId;
+    in>>uniqId>>snapshot->inlineNamespaces;
+    snapshot->uniqId = uniqId;
+
+    // statements, parents are always saved before their children
+    qint32 statementCount;
+    in>>statementCount;
+    if (in.status()!=QDataStream::Ok || statementCount<0)
+        return PSystemHeaderSnapshot();
+    QVector<PStatement>& statements = snapshot->statements;
+    statements.reserve(statementCount);
+    StringPool stringPool;
+    for (int i=0;i<statementCount;i++) {
+        PStatement statement = std::make_shared<Statement>();
+        qint32 parentIndex, kind, scope, accessibility, line, definitionLine, properties;
+        in>>parentIndex
+          >>statement->type>>statement->command>>statement->args
+          >>statement->noNameArgs>>statement->value
+          >>statement->templateSpecializationParams>>statement->fullName
+          >>kind>>scope>>accessibility>>line>>definitionLine
+          >>statement->fileName>>statement->definitionFileName
+          >>statement->friends>>statement->usingList>>statement->lambdaCaptures
+          >>properties;
+        if (in.status()!=QDataStream::Ok || parentIndex>=i)
+            return PSystemHeaderSnapshot();
+        statement->kind = (StatementKind)kind;
+        statement->scope = (StatementScope)scope;
+        statement->accessibility = (StatementAccessibility)accessibility;
+        statement->line = line;
+        statement->definitionLine = definitionLine;
+        statement->properties = StatementProperties(QFlag(properties));
+        stringPool.internStatementStrings(*statement);
+        statement->setReadOnly(true);
+        statement->usageCount = -1;
+        if (parentIndex>=0) {
+            const PStatement& parent = statements[parentIndex];
+            statement->parentScope = parent;
+            // QMultiMap::insert() puts newer items before older ones with the same key
+            parent->children.insert(statement->command, statement);
+        }
+        statements.append(statement);
+    }
+
+    // file infos and defines
+    for (int i=0;i<fileCount;i++) {
+        QString fileName;
+        QSet<QString> includes;
+        QStringList directIncludes;
+        QSet<QString> usings;
+        QList<qint32> statementIndice;
+        QList<qint32> scopeLines;
+        QList<qint32> scopeIndice;
+        QMap<qint32,bool> branches;
+        in>>fileName>>includes>>directIncludes>>usings
+          >>statementIndice>>scopeLines>>scopeIndice>>branches;
+        if (in.status()!=QDataStream::Ok || scopeLines.count()!=scopeIndice.count())
+            return PSystemHeaderSnapshot();
+        PParsedFileInfo fileInfo = std::make_shared<ParsedFileInfo>(fileName);
+        foreach (const QString& include, includes)
+            fileInfo->addInclude(include);
+        foreach (const QString& include, directIncludes)
+            fileInfo->addDirectInclude(include);
+        foreach (const QString& usingName, usings)
+            fileInfo->addUsing(usingName);
+        foreach (qint32 index, statementIndice) {
+            if (index<0 || index>=statements.count())
+                return PSystemHeaderSnapshot();
+            fileInfo->addStatement(statements[index]);
+        }
+        for (int j=0;j<scopeLines.count();j++) {
+            qint32 index = scopeIndice[j];
+            if (index>=statements.count())
+                return PSystemHeaderSnapshot();
+            fileInfo->addScope(scopeLines[j], index>=0?statements[index]:PStatement());
+        }
+        for (auto it=branches.constBegin();it!=branches.constEnd();++it)
+            fileInfo->insertBranch(it.key(), it.value());
+        fileInfo->setReadOnly(true);
+        snapshot->fileInfos.append(fileInfo);
+        snapshot->fileDefines.append(readDefineMap(in));
+        snapshot->fileUndefines.append(readDefineMap(in));
+    }
+    if (in.status()!=QDataStream::Ok)
+        return PSystemHeaderSnapshot();
+    return snapshot;
+}
+
+static bool systemHeaderSnapshotIsValid(const PSystemHeaderSnapshot& snapshot, const QString& cacheFile)
+{
+    if (QFileInfo(cacheFile).lastModified().toMSecsSinceEpoch()!=snapshot->cacheFileLastModified)
+        return false;
+    for (int i=0;i<snapshot->files.count();i++) {
+        QFileInfo info(snapshot->files[i]);
+        if (!info.exists() || info.lastModified().toMSecsSinceEpoch()!=snapshot->lastModifieds[i])
+            return false;
+    }
+    return true;
+}
+
+static QMutex systemHeaderSnapshotsMutex;
+static QHash<QString,std::weak_ptr<const SystemHeaderSnapshot>> systemHeaderSnapshots;
+
+bool CppParser::loadSystemHeaderCache()
+{
+    QMutexLocker locker(&mMutex);
+    if (mParsing || mSystemHeaderCacheFile.isEmpty())
+        return false;
+    QString key = systemHeaderCacheKey();
+    PSystemHeaderSnapshot snapshot;
+    {
+        // parsers using the same compiler settings share one snapshot
+        QMutexLocker snapshotsLocker(&systemHeaderSnapshotsMutex);
+        snapshot = systemHeaderSnapshots.value(mSystemHeaderCacheFile).lock();
+        if (!snapshot || !systemHeaderSnapshotIsValid(snapshot, mSystemHeaderCacheFile)) {
+            snapshot = readSystemHeaderSnapshot(mSystemHeaderCacheFile, key);
+            if (!snapshot) {
+                systemHeaderSnapshots.remove(mSystemHeaderCacheFile);
+                return false;
+            }
+            systemHeaderSnapshots.insert(mSystemHeaderCacheFile, snapshot);
+        }
+    }
+    foreach (const QString& fileName, snapshot->files) {
+        if (mPreprocessor.fileScanned(fileName))
+            return false;
+    }
+
+    // the statements are shared, only keep references to them
+    mStatementList.addReadOnlyStatements(snapshot->statements);
+    foreach (const PStatement& statement, snapshot->statements) {
+        if (statement->kind == StatementKind::Namespace) {
+            PStatementList namespaceList = doFindNamespace(statement->fullName);
+            if (!namespaceList) {
+                namespaceList=std::make_shared<StatementList>();
+                mNamespaces.insert(statement->fullName,namespaceList);
+            }
+            namespaceList->append(statement);
+        }
+    }
+    for (int i=0;i<snapshot->fileInfos.count();i++) {
+        const PDefineMap& defines = snapshot->fileDefines[i];
+        const PDefineMap& undefines = snapshot->fileUndefines[i];
+        // define maps are modified when the file is invalidated, so copy them
+        mPreprocessor.addScannedFile(snapshot->fileInfos[i],
+                                     defines?std::make_shared<DefineMap>(*defines):PDefineMap(),
+                                     undefines?std::make_shared<DefineMap>(*undefines):PDefineMap());
+    }
+    mInlineNamespaces.unite(snapshot->inlineNamespaces);
+    mUniqId = std::max(mUniqId, snapshot->uniqId);
+    mCachedSystemHeadersCount = snapshot->files.count();
+    mSystemHeaderSnapshot = snapshot;
+    return true;
+}
+
+QStringList CppParser::cacheableSystemHeaders() const
+{
+    QSet<QString> files;
+    foreach (const QString& file, mPreprocessor.scannedFiles()) {
+        if (::isSystemHeaderFile(file, mPreprocessor.includePaths())
+                && !::isSystemHeaderFile(file, mPreprocessor.projectIncludePaths()))
+            files.insert(file);
+    }
+    // Restored classes are shared and read-only, so the base classes not found yet
+    // can't be inherited later. Keep such classes out of the cache.
+    foreach (const PClassInheritanceInfo& inheritanceInfo, mClassInheritances) {
+        if (!inheritanceInfo->handled)
+            files.remove(inheritanceInfo->file);
+    }
+    // A header can't be restored alone if it includes files that are not cached
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        foreach (const QString& file, files) {
+            PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(file);
+            bool valid = (fileInfo!=nullptr);
+            if (valid) {
+                foreach (const QString& include, fileInfo->includes()) {
+                    if (!files.contains(include)) {
+                        valid = false;
+                        break;
+                    }
+                }
+            }
+            if (!valid) {
+                files.remove(file);
+                changed = true;
+            }
+        }
+    }
+    QStringList result = files.values();
+    result.sort();
+    return result;
+}
+
+void CppParser::saveSystemHeaderCache()
+{
+    QString cacheFile;
+    {
+        QMutexLocker locker(&mMutex);
+        cacheFile = mSystemHeaderCacheFile;
+    }
+    if (cacheFile.isEmpty())
+        return;
+    // We are called by the parse thread while parsing, nobody else changes the parser.
+    // Don't hold the lock while walking the files and writing the cache, readers would wait.
+    mSavedSystemHeaderScanCount = mPreprocessor.systemHeaderScanCount();
+    QStringList files = cacheableSystemHeaders();
+    if (files.count()<=mCachedSystemHeadersCount)
+        return;
+    QSet<QString> fileSet(files.begin(), files.end());
+
+    // collect statements declared in the cached files, parents before children
+    QVector<PStatement> statements;
+    QHash<Statement*,int> statementIndice;
+    QQueue<PStatement> queue;
+    queue.enqueue(PStatement());
+    while (!queue.isEmpty()) {
+        PStatement parent = queue.dequeue();
+        const StatementMap& children = mStatementList.childrenStatements(parent);
+        // QMultiMap::insert() puts newer items before older ones with the same key,
+        // so save them in reverse order to keep the order when loaded.
+        for (auto it=children.end();it!=children.begin();) {
+            --it;
+            const PStatement& statement = it.value();
+            if (!fileSet.contains(statement->fileName))
+                continue;
+            statementIndice.insert(statement.get(), statements.count());
+            statements.append(statement);
+            queue.enqueue(statement);
+        }
+    }
+
+    QSaveFile file(cacheFile);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+        return;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_15);
+    out<<SystemHeaderCacheMagic<<SystemHeaderCacheVersion<<systemHeaderCacheKey();
+    out<<(qint32)files.count();
+    foreach (const QString& fileName, files) {
+        out<<fileName<<(qint64)QFileInfo(fileName).lastModified().toMSecsSinceEpoch();
+    }
+    out<<(qint32)mUniqId<<mInlineNamespaces;
+
+    out<<(qint32)statements.count();
+    foreach (const PStatement& statement, statements) {
+        PStatement parent = statement->parentScope.lock();
+        qint32 parentIndex = parent?statementIndice.value(parent.get(),-1):-1;
+        QString definitionFileName = statement->definitionFileName;
+        int definitionLine = statement->definitionLine;
+        StatementProperties properties = statement->properties;
+        if (!fileSet.contains(definitionFileName)) {
+            // definition is in a non-system file, which will be reparsed
+            definitionFileName = statement->fileName;
+            definitionLine = statement->line;
+            properties.setFlag(StatementProperty::HasDefinition, false);
+        }
+        out<<parentIndex
+          <<statement->type<<statement->command<<statement->args
+          <<statement->noNameArgs<<statement->value
+          <<statement->templateSpecializationParams<<statement->fullName
+          <<(qint32)statement->kind<<(qint32)statement->scope
+          <<(qint32)statement->accessibility
+          <<(qint32)statement->line<<(qint32)definitionLine
+          <<statement->fileName<<definitionFileName
+          <<statement->friends<<statement->usingList<<statement->lambdaCaptures
+          <<(qint32)properties;
+    }
+
+    foreach (const QString& fileName, files) {
+        PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(fileName);
+        QList<qint32> indice;
+        foreach (const PStatement& statement, fileInfo->statements()) {
+            int index = statementIndice.value(statement.get(),-1);
+            if (index>=0)
+                indice.append(index);
+        }
+        QList<qint32> scopeLines;
+        QList<qint32> scopeIndice;
+        foreach (const PCppScope& scope, fileInfo->scopes().scopes()) {
+            int index = -1;
+            if (scope->statement) {
+                index = statementIndice.value(scope->statement.get(),-1);
+                if (index<0)
+                    continue;
+            }
+            scopeLines.append(scope->startLine);
+            scopeIndice.append(index);
+        }
+        QMap<qint32,bool> branches;
+        for (auto it=fileInfo->branches().constBegin();it!=fileInfo->branches().constEnd();++it)
+            branches.insert(it.key(),it.value());
+        out<<fileName<<fileInfo->includes()<<fileInfo->directIncludes()<<fileInfo->usings()
+          <<indice<<scopeLines<<scopeIndice<<branches;
+        writeDefineMap(out, mPreprocessor.fileDefines(fileName));
+        writeDefineMap(out, mPreprocessor.fileUndefines(fileName));
+    }
+    if (out.status()==QDataStream::Ok && file.commit())
+        mCachedSystemHeadersCount = files.count();
+}
+
 bool CppParser::parsing() const
 {
     return mParsing;
@@ -1209,6 +1774,7 @@ void CppParser::resetParser()
         });
         emit  onBusy();
         mUniqId = 0;
+        mStringPool.clear();
 
         mIsSystemHeader = false;
         mIsHeader = false;
@@ -1230,6 +1796,13 @@ void CppParser::resetParser()
         mClassInheritances.clear();
         mPreprocessor.clear();
         mTokenizer.clear();
+        mSystemHeaderCacheFile.clear();
+        mCachedSystemHeadersCount = 0;
+        mSavedSystemHeaderScanCount = 0;
+        mSystemHeaderSnapshot.reset();
+        mReadSnapshot.reset();
+        mReadSnapshotWanted = false;
+        mReadSnapshotOutdated = false;
     }
 }
 
@@ -1237,6 +1810,135 @@ void CppParser::unFreeze()
 {
     QMutexLocker locker(&mMutex);
     mLockCount--;
+    if (mLockCount==0)
+        schedulePendingParseCommands();
+}
+
+PCppParser CppParser::readSnapshot() const
+{
+    QMutexLocker locker(&mMutex);
+    return doGetReadSnapshot();
+}
+
+PCppParser CppParser::doGetReadSnapshot() const
+{
+    // someone reads while parsing, so publish a copy even if another parsing is queued
+    mReadSnapshotWanted = true;
+    return mReadSnapshot;
+}
+
+// Copying too many statements after each parsing costs more than it saves
+static constexpr int MaxReadSnapshotStatements = 100000;
+
+PCppParser CppParser::createReadSnapshot() const
+{
+    // statements of the system header snapshot are read-only, so they are shared
+    int sharedCount = mSystemHeaderSnapshot?mSystemHeaderSnapshot->statements.count():0;
+    if (mStatementList.count() - sharedCount > MaxReadSnapshotStatements)
+        return PCppParser();
+    QSet<const ParsedFileInfo*> sharedFileInfos;
+    if (mSystemHeaderSnapshot) {
+        foreach (const PParsedFileInfo& fileInfo, mSystemHeaderSnapshot->fileInfos)
+            sharedFileInfos.insert(fileInfo.get());
+    }
+
+    QHash<const Statement*, PStatement> copies;
+    StatementMapper mapStatement = [&copies, &mapStatement](const PStatement& statement) -> PStatement {
+        if (!statement || statement->isReadOnly())
+            return statement;
+        PStatement copy = copies.value(statement.get());
+        if (copy)
+            return copy;
+        copy = std::make_shared<Statement>(*statement);
+        copy->children.clear();
+        copy->matchPositions.clear();
+        copies.insert(statement.get(), copy);
+        copy->parentScope = mapStatement(statement->parentScope.lock());
+        return copy;
+    };
+    // copy the statement tree, parents are copied before their children
+    QQueue<PStatement> queue;
+    QSet<const Statement*> visited;
+    foreach (const PStatement& statement, mStatementList.childrenStatements()) {
+        if (!statement->isReadOnly())
+            queue.enqueue(statement);
+    }
+    // statements with shared parents are not in their parents' children
+    foreach (const PParsedFileInfo& fileInfo, mPreprocessor.fileInfos()) {
+        if (sharedFileInfos.contains(fileInfo.get()))
+            continue;
+        foreach (const PStatement& statement, fileInfo->statements()) {
+            PStatement parent = statement->parentScope.lock();
+            if (!statement->isReadOnly() && parent && parent->isReadOnly())
+                queue.enqueue(statement);
+        }
+    }
+    while (!queue.isEmpty()) {
+        PStatement statement = queue.dequeue();
+        if (visited.contains(statement.get()))
+            continue;
+        visited.insert(statement.get());
+        PStatement copy = mapStatement(statement);
+        // QMultiMap::insert() puts newer items before older ones with the same key
+        for (auto it=statement->children.constEnd();it!=statement->children.constBegin();) {
+            --it;
+            copy->children.insert(it.key(), mapStatement(it.value()));
+            if (!it.value()->isReadOnly())
+                queue.enqueue(it.value());
+        }
+    }
+
+    PCppParser snapshot = std::make_shared<CppParser>();
+    snapshot->setLanguage(mLanguage);
+    snapshot->mEnabled = mEnabled;
+    snapshot->mSerialId = mSerialId;
+    snapshot->mUniqId = mUniqId;
+    snapshot->mSharedByFiles = mSharedByFiles;
+    snapshot->mProjectFiles = mProjectFiles;
+    snapshot->mInlineNamespaces = mInlineNamespaces;
+    snapshot->mSystemHeaderSnapshot = mSystemHeaderSnapshot;
+    snapshot->mStatementList.copyFrom(mStatementList, mapStatement);
+    snapshot->mPreprocessor.copyFrom(mPreprocessor,
+                                     [&sharedFileInfos, &mapStatement](const PParsedFileInfo& fileInfo) {
+        if (sharedFileInfos.contains(fileInfo.get()))
+            return fileInfo;
+        return fileInfo->clone(mapStatement);
+    });
+    for (auto it=mNamespaces.constBegin();it!=mNamespaces.constEnd();++it) {
+        PStatementList namespaceList = std::make_shared<StatementList>();
+        foreach (const PStatement& statement, *(it.value()))
+            namespaceList->append(mapStatement(statement));
+        snapshot->mNamespaces.insert(it.key(), namespaceList);
+    }
+    return snapshot;
+}
+
+void CppParser::publishReadSnapshot()
+{
+    {
+        QMutexLocker locker(&mMutex);
+        // the copy would be outdated as soon as the queued parsing starts, let it publish one
+        // unless someone already reads while this parsing runs
+        if (!mPendingParseCommands.isEmpty() && !mReadSnapshotWanted)
+            return;
+        mReadSnapshotWanted = false;
+    }
+    // copy without holding the lock, readers use the old copy meanwhile
+    PCppParser snapshot = createReadSnapshot();
+    // we are in a parse job, the copy should live in the parser's thread
+    if (snapshot)
+        snapshot->moveToThread(thread());
+    QMutexLocker locker(&mMutex);
+    mReadSnapshot = snapshot;
+    mReadSnapshotOutdated = false;
+}
+
+void CppParser::retireReadSnapshot()
+{
+    // a parsing is starting, readers may use the result of the last parsing but nothing older
+    if (mReadSnapshotOutdated)
+        mReadSnapshot.reset();
+    mReadSnapshotOutdated = true;
 }
 
 bool CppParser::fileScanned(const QString &fileName) const
@@ -1509,16 +2211,16 @@ PStatement CppParser::addStatement(const PStatement& parent,
         //find
         if (properties.testFlag(StatementProperty::HasDefinition)) {
             PStatement oldStatement = findStatementInScope(newCommand,noNameArgs,kind,parent);
-            if (oldStatement  && !oldStatement->hasDefinition()) {
+            if (oldStatement  && !oldStatement->hasDefinition() && !oldStatement->isReadOnly()) {
                 oldStatement->setHasDefinition(true);
                 if (oldStatement->fileName!=fileName) {
                     PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(fileName);
-                    if (fileInfo) {
+                    if (fileInfo && !fileInfo->isReadOnly()) {
                         fileInfo->addStatement(oldStatement);
                     }
                 }
                 oldStatement->definitionLine = line;
-                oldStatement->definitionFileName = fileName;
+                oldStatement->definitionFileName = mStringPool.intern(fileName);
                 return oldStatement;
             }
         }
@@ -1557,10 +2259,11 @@ PStatement CppParser::addStatement(const PStatement& parent,
         result->fullName =  getFullStatementName(newCommand + templateSpecializationParams, parent);
     result->usageCount = -1;
 
-    result->args.squeeze();
-    result->noNameArgs.squeeze();
     result->value.squeeze();
-    result->type.squeeze();
+    mStringPool.internStatementStrings(*result);
+    // If the parent is shared (from the system header cache), like the class of an
+    // out-of-line member definition, the statement is not added to its children.
+    // It's still found by its file info and scopes, and its own children are added.
     mStatementList.add(result);
     if (result->kind == StatementKind::Namespace) {
         PStatementList namespaceList = doFindNamespace(result->fullName);
@@ -1573,7 +2276,8 @@ PStatement CppParser::addStatement(const PStatement& parent,
 
     if (result->kind!= StatementKind::Block) {
         PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(fileName);
-        if (fileInfo) {
+        // inherited statements use the file name of the base class, which may be a shared info
+        if (fileInfo && !fileInfo->isReadOnly()) {
             fileInfo->addStatement(result);
         }
     }
@@ -1863,7 +2567,7 @@ void CppParser::removeScopeLevel(int line, int maxIndex)
                     fileInfo->removeLastScope();
                 mStatementList.deleteStatement(currentScope);
             } else {
-                if (fileInfo)
+                if (fileInfo && !currentScope->isReadOnly())
                     fileInfo->addStatement(currentScope);
             }
         } else if (currentScope->kind == StatementKind::Class) {
@@ -4525,7 +5229,9 @@ void CppParser::handleInheritance(PStatement derivedStatement, PClassInheritance
         inheritanceInfo->handled = true;
         PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(statement->fileName);
         Q_ASSERT(fileInfo!=nullptr);
-        fileInfo->addHandledInheritances(inheritanceInfo);
+        // shared infos are never invalidated, so there's no need to track the inheritance there
+        if (fileInfo && !fileInfo->isReadOnly())
+            fileInfo->addHandledInheritances(inheritanceInfo);
     }
 
 }
@@ -4625,6 +5331,19 @@ void CppParser::internalParse(const QString &fileName)
         mTokenizer.clear();
     });
     //timer.start();
+    QStringList preprocessResult = internalPreprocess(fileName);
+
+    //timer.restart();
+    // Tokenize the preprocessed buffer file
+    mTokenizer.tokenize(preprocessResult);
+    //reduce memory usage
+    preprocessResult.clear();
+    //qDebug()<<"tokenize"<<timer.elapsed();
+    internalParseTokens(fileName);
+}
+
+QStringList CppParser::internalPreprocess(const QString &fileName)
+{
     // Let the preprocessor augment the include records
     mPreprocessor.setScanOptions(true, true);
     mPreprocessor.preprocess(fileName);
@@ -4640,17 +5359,17 @@ void CppParser::internalParse(const QString &fileName)
     //timer.restart();
     mPreprocessor.clearTempResults();
     //qDebug()<<"preprocess clean"<<timer.elapsed();
+    return preprocessResult;
+}
 
-    //timer.restart();
-    // Tokenize the preprocessed buffer file
-    mTokenizer.tokenize(preprocessResult);
-    //reduce memory usage
-    preprocessResult.clear();
-    //qDebug()<<"tokenize"<<timer.elapsed();
+void CppParser::internalParseTokens(const QString &fileName)
+{
     if (mTokenizer.tokenCount() == 0)
         return;
 #ifdef PARSER_DEBUG_LOG
      mTokenizer.dumpTokens(QString(DebugLogFolder+"/tokens-%1.txt").arg(extractFileName(fileName)));
+#else
+     Q_UNUSED(fileName);
 #endif
 #ifdef QT_DEBUG
         mLastIndex = -1;
@@ -4675,6 +5394,257 @@ void CppParser::internalParse(const QString &fileName)
     internalClear();
 }
 
+namespace {
+class CppTokenizeTask : public QRunnable {
+public:
+    CppTokenizeTask(const PCppTokenizer& tokenizer, const QStringList& buffer):
+        mTokenizer{tokenizer}, mBuffer{buffer} {}
+    void run() override {
+        mTokenizer->tokenize(mBuffer);
+        mBuffer.clear();
+    }
+private:
+    PCppTokenizer mTokenizer;
+    QStringList mBuffer;
+};
+}
+
+void CppParser::internalParseFiles(const QStringList &files)
+{
+    if (!mEnabled)
+        return;
+    int threadCount = QThread::idealThreadCount();
+    if (threadCount<=1 || files.count()<=1) {
+        for (int i=0;i<files.count();i++) {
+            const QString& file = files[i];
+            if (mStopParse) {
+                // parse the rest later
+                for (int j=i;j<files.count();j++)
+                    mFilesToScan.insert(files[j]);
+                return;
+            }
+            mFilesScannedCount++;
+            emit progress(file,mFilesToScanCount,mFilesScannedCount);
+            if (!mPreprocessor.fileScanned(file)) {
+                internalParse(file);
+            }
+        }
+        return;
+    }
+    // Preprocessing must be done in order, because it depends on the macros
+    // and the scanned files of the previous files. And handling statements depends
+    // on the statements of the previous files.
+    // So only tokenizing is done by the thread pool, while the next file is preprocessing.
+    // Files are handled in batches to limit the memory used by the tokens.
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+    int batchSize = threadCount * 2;
+    auto action = finally([this,&pool]{
+        pool.waitForDone();
+        mTokenizer.clear();
+    });
+    for (int start=0; start<files.count(); start+=batchSize) {
+        // stop before preprocessing the batch, files are marked as scanned by the preprocessor
+        if (mStopParse) {
+            for (int j=start;j<files.count();j++)
+                mFilesToScan.insert(files[j]);
+            return;
+        }
+        int end = std::min(start+batchSize, (int)files.count());
+        QVector<PCppTokenizer> tokenizers(end-start);
+        for (int i=start;i<end;i++) {
+            const QString& file = files[i];
+            if (file.isEmpty() || mPreprocessor.fileScanned(file))
+                continue;
+            PCppTokenizer tokenizer = std::make_shared<CppTokenizer>();
+            pool.start(new CppTokenizeTask(tokenizer, internalPreprocess(file)));
+            tokenizers[i-start] = tokenizer;
+        }
+        pool.waitForDone();
+        for (int i=start;i<end;i++) {
+            mFilesScannedCount++;
+            emit progress(files[i],mFilesToScanCount,mFilesScannedCount);
+            PCppTokenizer& tokenizer = tokenizers[i-start];
+            if (!tokenizer)
+                continue;
+            mTokenizer.swap(*tokenizer);
+            tokenizer.reset();
+            internalParseTokens(files[i]);
+            mTokenizer.clear();
+        }
+    }
+}
+
+static bool isFunctionKind(StatementKind kind)
+{
+    switch(kind) {
+    case StatementKind::Function:
+    case StatementKind::Constructor:
+    case StatementKind::Destructor:
+    case StatementKind::OverloadedOperator:
+    case StatementKind::LiteralOperator:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool CppParser::reparseFunctionBody(const QString &fileName, const QStringList &contents, int firstChangedLine, int lastChangedLine, int lineDelta)
+{
+    {
+        QMutexLocker locker(&mMutex);
+        if (!doReparseFunctionBody(fileName, contents, firstChangedLine, lastChangedLine, lineDelta))
+            return false;
+    }
+    // all editors using the parser should refresh, not only the one that is edited
+    emit functionBodyReparsed(fileName);
+    return true;
+}
+
+bool CppParser::doReparseFunctionBody(const QString &fileName, const QStringList &contents, int firstChangedLine, int lastChangedLine, int lineDelta)
+{
+    if (!mEnabled || mParsing || mLockCount>0)
+        return false;
+    // a queued parsing may not have run yet, the scopes may not match the caller's old contents
+    if (!mPendingParseCommands.isEmpty())
+        return false;
+    PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(fileName);
+    if (!fileInfo || fileInfo->isReadOnly())
+        return false;
+
+    // find the outermost function that contains the changed lines
+    // (or the line before them, if lines are only inserted)
+    PStatement function;
+    PStatement scope = fileInfo->findScopeAtLine(std::min(firstChangedLine, lastChangedLine));
+    while (scope) {
+        if (isFunctionKind(scope->kind))
+            function = scope;
+        scope = scope->parentScope.lock();
+    }
+    if (!function)
+        return false;
+    auto inFunction = [&function](PStatement statement) {
+        while (statement) {
+            if (statement == function)
+                return true;
+            statement = statement->parentScope.lock();
+        }
+        return false;
+    };
+    if (lastChangedLine>=firstChangedLine
+            && !inFunction(fileInfo->findScopeAtLine(lastChangedLine)))
+        return false;
+
+    // the function scope starts at its header line, and ends at the line of its '}'
+    int startLine = -1;
+    PCppScope endScope;
+    foreach (const PCppScope& cppScope, fileInfo->scopes().scopes()) {
+        if (startLine<0) {
+            if (cppScope->statement == function)
+                startLine = cppScope->startLine;
+        } else if (!inFunction(cppScope->statement)) {
+            endScope = cppScope;
+            break;
+        }
+    }
+    if (startLine<0 || !endScope)
+        return false;
+    // lines of the last parsed contents
+    int endLine = endScope->startLine;
+    // lines of the current contents
+    int newEndLine = endLine + lineDelta;
+    if (newEndLine>=contents.count()
+            || firstChangedLine<=startLine || lastChangedLine>=endLine)
+        return false;
+
+    QStringList buffer = contents.mid(startLine, newEndLine-startLine+1);
+    CppPreprocessor::combineLinesEndingWithBackslash(buffer);
+    CppPreprocessor::replaceCommentsBySpaceChar(buffer);
+    for (int i=0;i<buffer.count();i++) {
+        // directives may change the macros used by other files
+        if (buffer[i].trimmed().startsWith('#'))
+            return false;
+        buffer[i] = mPreprocessor.expandMacros(buffer[i]);
+    }
+    buffer.prepend(QString("#include %1:%2").arg(fileName).arg(startLine-1));
+    CppTokenizer tokenizer;
+    tokenizer.tokenize(buffer);
+    if (tokenizer.hasUnmatchedPairs())
+        return false;
+
+    // find the body braces, they should be outside of the changed lines
+    int bodyStart = -1;
+    int bodyEnd = -1;
+    for (int i=0;i<tokenizer.tokenCount();i++) {
+        if (tokenizer[i]->text=='{') {
+            int matchIndex = tokenizer[i]->matchIndex;
+            if (matchIndex>i && tokenizer[matchIndex]->line == newEndLine) {
+                bodyStart = i;
+                bodyEnd = matchIndex;
+                break;
+            }
+            if (matchIndex>i)
+                i = matchIndex;
+        }
+    }
+    if (bodyStart<0 || tokenizer[bodyStart]->line>=firstChangedLine)
+        return false;
+
+    mParsing = true;
+    retireReadSnapshot();
+    auto action = finally([this]{
+        mTokenizer.clear();
+        internalClear();
+        mParsing = false;
+    });
+    removeLocalStatements(function, fileInfo);
+    QVector<PCppScope> scopesAfter = fileInfo->takeScopesAfter(startLine);
+    // scopes of blocks ending on the function's last line (like "}}") are in the body too
+    while (!scopesAfter.isEmpty() && scopesAfter.front()!=endScope)
+        scopesAfter.pop_front();
+    if (lineDelta!=0) {
+        foreach (const PCppScope& cppScope, scopesAfter)
+            cppScope->startLine += lineDelta;
+        fileInfo->shiftLines(endLine, lineDelta);
+    }
+
+    mTokenizer.swap(tokenizer);
+    mCurrentFile = fileInfo->fileName();
+    mIsSystemHeader = isSystemHeaderFile(mCurrentFile) || isProjectHeaderFile(mCurrentFile);
+    mIsProjectFile = mProjectFiles.contains(mCurrentFile);
+    mIsHeader = isHFile(mCurrentFile);
+    mCurrentScope.append(function);
+    mCurrentMemberAccessibility = StatementAccessibility::None;
+    mMemberAccessibilities.append(mCurrentMemberAccessibility);
+#ifdef QT_DEBUG
+    mLastIndex = -1;
+#endif
+    mIndex = bodyStart+1;
+    while (handleStatement(bodyEnd));
+    handleInheritances();
+
+    fileInfo->appendScopes(scopesAfter);
+    return true;
+}
+
+void CppParser::removeLocalStatements(const PStatement &statement, const PParsedFileInfo &fileInfo)
+{
+    // statements in the function body, parameters and implicit variables are kept
+    QList<PStatement> children = statement->children.values();
+    foreach (const PStatement& child, children) {
+        if (child->fileName!=fileInfo->fileName())
+            continue;
+        if (isFunctionKind(statement->kind)
+                && (child->kind == StatementKind::Parameter
+                    || child->command == "this"
+                    || child->command == "__func__"))
+            continue;
+        removeLocalStatements(child, fileInfo);
+        fileInfo->removeStatement(child);
+        mStatementList.deleteStatement(child);
+    }
+}
+
 void CppParser::inheritClassStatement(const PStatement& derived, bool isStruct,
                                       const PStatement& base, StatementAccessibility access)
 {
@@ -6220,7 +7190,7 @@ void CppParser::internalInvalidateFile(const QString &fileName)
         for(PStatement statement:p->statements()) {
             if (statement->fileName==fileName) {
                 mStatementList.deleteStatement(statement);
-            } else {
+            } else if (!statement->isReadOnly()) {
                 statement->setHasDefinition(false);
                 statement->definitionFileName = statement->fileName;
                 statement->definitionLine = statement->line;
@@ -6267,6 +7237,38 @@ void CppParser::internalInvalidateFiles(const QSet<QString> &files)
 {
     for (const QString& file:files)
         internalInvalidateFile(file);
+    if (mStringPool.shouldPrune())
+        mStringPool.prune(ownStatements());
+}
+
+QList<PStatement> CppParser::ownStatements() const
+{
+    // shared statements (from the system header cache) are not ours
+    QList<PStatement> result;
+    QQueue<PStatement> queue;
+    foreach (const PStatement& statement, mStatementList.childrenStatements()) {
+        if (!statement->isReadOnly())
+            queue.enqueue(statement);
+    }
+    // statements with shared parents are not in their parents' children
+    foreach (const PParsedFileInfo& fileInfo, mPreprocessor.fileInfos()) {
+        if (fileInfo->isReadOnly())
+            continue;
+        foreach (const PStatement& statement, fileInfo->statements()) {
+            PStatement parent = statement->parentScope.lock();
+            if (!statement->isReadOnly() && parent && parent->isReadOnly())
+                queue.enqueue(statement);
+        }
+    }
+    while (!queue.isEmpty()) {
+        PStatement statement = queue.dequeue();
+        result.append(statement);
+        foreach (const PStatement& child, statement->children) {
+            if (!child->isReadOnly())
+                queue.enqueue(child);
+        }
+    }
+    return result;
 }
 
 QSet<QString> CppParser::calculateFilesToBeReparsed(const QString &fileName)
@@ -7032,72 +8034,24 @@ void CppParser::setEnabled(bool newEnabled)
     }
 }
 
-CppFileParserThread::CppFileParserThread(
-        PCppParser parser,
-        const QString &fileName,
-        bool inProject,
-        const QString &contextFilename,
-        bool onlyIfNotParsed,
-        bool updateView,
-        QObject *parent):QThread{parent},
-    mParser{parser},
-    mFileName{fileName},
-    mInProject{inProject},
-    mContextFilename{contextFilename},
-    mOnlyIfNotParsed{onlyIfNotParsed},
-    mUpdateView{updateView}
-{
-    connect(this,&QThread::finished,
-            this,&QObject::deleteLater);
-}
-
-CppFileParserThread::~CppFileParserThread()
-{
-}
-
-void CppFileParserThread::run()
-{
-    if (mParser) {
-        if (mParser->parseFile(mFileName,mInProject,mContextFilename,mOnlyIfNotParsed,mUpdateView)) {
-            CppParser::PParseFileCommand command;
-            while ( (command = mParser->retrievePendingParseFileCommand()) != nullptr) {
-                if (!mParser->parseFile(command->fileName,
-                                   command->inProject,
-                                   command->contextFilename,
-                                   command->onlyIfNotParsed,
-                                   command->updateView))
-                    break;
-            }
-        }
-    }
-}
-
-CppFileListParserThread::CppFileListParserThread(PCppParser parser,
-                                                 bool updateView, QObject *parent):
-    QThread(parent),
-    mParser(parser),
-    mUpdateView(updateView)
-{
-    connect(this,&QThread::finished,
-            this,&QObject::deleteLater);
-}
-
-void CppFileListParserThread::run()
-{
-    if (mParser && !mParser->parsing()) {
-        mParser->parseFileList(mUpdateView);
-    }
-}
-
 void CppParser::parseFileNonBlocking(PCppParser parser, const QString &fileName, bool inProject, const QString &contextFilename,
-                          bool onlyIfNotParsed, bool updateView)
+                          bool onlyIfNotParsed, bool updateView, bool highPriority)
 {
     if (!parser)
         return;
     if (!parser->enabled())
         return;
-    CppFileParserThread* thread = new CppFileParserThread(parser,fileName,inProject,contextFilename,onlyIfNotParsed,updateView);
-    thread->start();
+    PParseFileCommand command = std::make_shared<ParseFileCommand>();
+    command->fileName = fileName;
+    command->inProject = inProject;
+    command->contextFilename = contextFilename;
+    command->onlyIfNotParsed = onlyIfNotParsed;
+    command->updateView = updateView;
+    command->fileList = false;
+    command->invalidateOnly = false;
+    command->highPriority = highPriority;
+    parser->enqueueParseCommand(std::move(command));
+    parser->schedulePendingParseCommands();
 }
 
 void CppParser::parseFileListNonBlocking(PCppParser parser, bool updateView)
@@ -7106,7 +8060,7 @@ void CppParser::parseFileListNonBlocking(PCppParser parser, bool updateView)
         return;
     if (!parser->enabled())
         return;
-    CppFileListParserThread *thread = new CppFileListParserThread(parser,updateView);
-    thread->start();
+    parser->enqueueFileListCommand(updateView);
+    parser->schedulePendingParseCommands();
 }
 
@@ -21,6 +21,7 @@
 #include <QObject>
 #include <QThread>
 #include <QVector>
+#include <atomic>
 #include "statementmodel.h"
 #include "cpptokenizer.h"
 #include "cpppreprocessor.h"
@@ -28,7 +29,26 @@
 class CppParser;
 using PCppParser = std::shared_ptr<CppParser>;
 
-class CppParser : public QObject
+/**
+ * @brief Symbols of system headers loaded from the parser cache.
+ *
+ * The snapshot and its statements are read-only, and shared by all parsers
+ * using the same compiler settings.
+ */
+struct SystemHeaderSnapshot {
+    QStringList files;
+    QList<qint64> lastModifieds; // of files
+    qint64 cacheFileLastModified;
+    QVector<PStatement> statements; // parents are before their children
+    QList<PParsedFileInfo> fileInfos;
+    QList<PDefineMap> fileDefines;
+    QList<PDefineMap> fileUndefines;
+    QSet<QString> inlineNamespaces;
+    int uniqId;
+};
+using PSystemHeaderSnapshot = std::shared_ptr<const SystemHeaderSnapshot>;
+
+class CppParser : public QObject, public std::enable_shared_from_this<CppParser>
 {
     Q_OBJECT
 public:
@@ -38,8 +58,11 @@ public:
         QString contextFilename;
         bool onlyIfNotParsed;
         bool updateView;
+        bool fileList; // parse the files to scan, fileName is not used
+        bool invalidateOnly; // only invalidate fileName (and files depending on it), don't parse it
+        bool highPriority; // e.g. the file is in the focused editor
     };
-    using PParseFileCommand = std::unique_ptr<ParseFileCommand>;
+    using PParseFileCommand = std::shared_ptr<ParseFileCommand>;
 
     explicit CppParser();
     CppParser(const CppParser&)=delete;
@@ -124,6 +147,15 @@ public:
     bool isSystemHeaderFile(const QString& fileName) const;
     void parseHardDefines();
     bool parsing() const;
+    /**
+     * @brief the last published read-only copy of the parser
+     *
+     * Queries are answered by the copy while the parser is parsing, so they
+     * don't have to wait for the parsing to finish. Copies are only made
+     * after a parsing if the copy has been asked for since the last one.
+     * @return nullptr if no copy has been published
+     */
+    PCppParser readSnapshot() const;
     void resetParser();
     void unFreeze(); // UnFree/UnLock (reparse while searching)
     bool fileScanned(const QString& fileName) const;
@@ -156,6 +188,19 @@ public:
 
     QList<QString> namespaces();
 
+    /**
+     * @brief key of the on-disk system header cache for the current parser settings
+     *  (language, include paths and hard defines)
+     */
+    QString systemHeaderCacheKey() const;
+    const QString &systemHeaderCacheFile() const;
+    void setSystemHeaderCacheFile(const QString &newSystemHeaderCacheFile);
+    /**
+     * @brief load parsed system headers from the cache file
+     * @return false if the cache doesn't exist or is outdated
+     */
+    bool loadSystemHeaderCache();
+
     static bool isIdentifier(const QString& token){
         return (!token.isEmpty() && isIdentifierChar(token.front()));
         // return (!token.isEmpty() && isIdentChar(token.front())
@@ -184,25 +229,53 @@ public:
         bool inProject,
         const QString &contextFilename,
         bool onlyIfNotParsed = false,
-        bool updateView = true);
+        bool updateView = true,
+        bool highPriority = false);
 
     static void parseFileListNonBlocking(
             PCppParser parser,
             bool updateView = true);
 
+    /**
+     * @brief reparse the body of the function which contains all the changed lines
+     * @param fileName
+     * @param contents current contents of the file
+     * @param firstChangedLine
+     * @param lastChangedLine last changed line in the last parsed contents,
+     *  firstChangedLine-1 if lines are only inserted
+     * @param lineDelta lines added (or removed if negative) by the change
+     * @return false if the changed lines are not inside one function body, or the new
+     *  body can't be handled separately. The whole file should be reparsed in that case.
+     */
+    bool reparseFunctionBody(const QString& fileName,
+                             const QStringList& contents,
+                             int firstChangedLine,
+                             int lastChangedLine,
+                             int lineDelta);
+
 
 signals:
     void progress(const QString& fileName, int total, int current);
     void onBusy();
     void parseStarted();
     void parseFinished(int total, int updateView);
+    void functionBodyReparsed(const QString& fileName);
 private:
     bool parseFile(const QString& fileName, bool inProject,
                    const QString& contextFilename,
                    bool onlyIfNotParsed = false, bool updateView = true
                    );
     void parseFileList(bool updateView = true);
-    PParseFileCommand retrievePendingParseFileCommand();
+    void enqueueParseCommand(PParseFileCommand command);
+    PParseFileCommand takePendingParseCommand();
+    void enqueueFileListCommand(bool updateView);
+    void schedulePendingParseCommands();
+    PCppParser doGetReadSnapshot() const;
+    PCppParser createReadSnapshot() const;
+    void publishReadSnapshot();
+    void retireReadSnapshot();
+    QStringList cacheableSystemHeaders() const;
+    void saveSystemHeaderCache();
 
     PStatement addInheritedStatement(
             const PStatement& derived,
@@ -568,6 +641,15 @@ private:
     void handleLabel();
     void skipRequires(int maxIndex);
     void internalParse(const QString& fileName);
+    QStringList internalPreprocess(const QString& fileName);
+    void internalParseTokens(const QString& fileName);
+    void internalParseFiles(const QStringList& files);
+    bool doReparseFunctionBody(const QString& fileName,
+                               const QStringList& contents,
+                               int firstChangedLine,
+                               int lastChangedLine,
+                               int lineDelta);
+    void removeLocalStatements(const PStatement& statement, const PParsedFileInfo& fileInfo);
 //    function FindMacroDefine(const Command: AnsiString): PStatement;
     void inheritClassStatement(
             const PStatement& derived,
@@ -580,6 +662,7 @@ private:
                                       const PStatement& scope) const;
     void internalInvalidateFile(const QString& fileName);
     void internalInvalidateFiles(const QSet<QString>& files);
+    QList<PStatement> ownStatements() const;
     QSet<QString> calculateFilesToBeReparsed(const QString& fileName);
     void scanMethodArgs(
             const PStatement& functionStatement,
@@ -727,6 +810,7 @@ private:
     int mSerialCount;
     QString mSerialId;
     int mUniqId;
+    StringPool mStringPool;
     bool mEnabled;
     int mIndex;
     bool mIsHeader;
@@ -756,7 +840,8 @@ private:
     QHash<QString,PStatementList> mNamespaces;  // namespace and the statements in its scope
     QList<PClassInheritanceInfo> mClassInheritances;
     QSet<QString> mInlineNamespaces;
-    bool mStopParse;
+    std::atomic<bool> mStopParse; // the running parsing is stale, stop it before the next file
+    QString mParsingFileName; // file of the running parseFile()
 #ifdef QT_DEBUG
     int mLastIndex;
 #endif
@@ -764,53 +849,18 @@ private:
     QMap<QString,KeywordType> mCppKeywords;
     QSet<QString> mCppTypeKeywords;
 
-    PParseFileCommand mLastParseFileCommand;
+    QList<PParseFileCommand> mPendingParseCommands; // high priority commands are at front
+    bool mParseJobScheduled;
 
-    friend class CppFileListParserThread;
-    friend class CppFileParserThread;
+    QString mSystemHeaderCacheFile;
+    int mCachedSystemHeadersCount;
+    int mSavedSystemHeaderScanCount; // system header scan count of the preprocessor at the last save
+    PSystemHeaderSnapshot mSystemHeaderSnapshot;
+    PCppParser mReadSnapshot;
+    mutable bool mReadSnapshotWanted;
+    bool mReadSnapshotOutdated; // the read snapshot is not published by the last parsing
 
-};
-
-class CppFileParserThread : public QThread {
-    Q_OBJECT
-public:
-    explicit CppFileParserThread(
-            PCppParser parser,
-            const QString &fileName,
-            bool inProject,
-            const QString &contextFilename,
-            bool onlyIfNotParsed = false,
-            bool updateView = true,
-            QObject *parent = nullptr);
-    ~CppFileParserThread();
-private:
-    PCppParser mParser;
-    QString mFileName;
-    bool mInProject;
-    QString mContextFilename;
-    bool mOnlyIfNotParsed;
-    bool mUpdateView;
-    int mId;
-
-    // QThread interface
-protected:
-    void run() override;
-};
-using PCppParserThread = std::shared_ptr<CppFileParserThread>;
-
-class CppFileListParserThread: public QThread {
-    Q_OBJECT
-public:
-    explicit CppFileListParserThread(
-            PCppParser parser,
-            bool updateView = true,
-            QObject *parent = nullptr);
-private:
-    PCppParser mParser;
-    bool mUpdateView;
-    // QThread interface
-protected:
-    void run() override;
+    friend class CppParseJob;
 };
 
 #endif // CPPPARSER_H
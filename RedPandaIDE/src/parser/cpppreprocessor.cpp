@@ -38,6 +38,8 @@ CppPreprocessor::CppPreprocessor()
     mPreprocessorHandlers.insert("include_next",[this](const QString& tokens){ handleIncludeNext(tokens);});
     mParseLocal = true;
     mParseSystem = true;
+    mSystemHeaderScanCount = 0;
+    mMacroLookups = nullptr;
 }
 
 void CppPreprocessor::clear()
@@ -56,6 +58,7 @@ void CppPreprocessor::clear()
     //{ List of current project's include path }
     mHardDefines.clear();
     mDefines.clear();
+    mMacroExpansions.clear();
     //mHardDefines.clear(); // set by "cpp -dM -E -xc NUL"
     mProjectIncludePaths.clear();
     //we also need include paths in order (for #include_next)
@@ -66,6 +69,29 @@ void CppPreprocessor::clear()
     mSupportCPP23=false;
 }
 
+void CppPreprocessor::copyFrom(const CppPreprocessor &other,
+                               const std::function<PParsedFileInfo (const PParsedFileInfo &)> &cloneFileInfo)
+{
+    clear();
+    mDefines = other.mDefines;
+    for (auto it=other.mFileInfos.constBegin();it!=other.mFileInfos.constEnd();++it)
+        mFileInfos.insert(it.key(), cloneFileInfo(it.value()));
+    for (auto it=other.mFileDefines.constBegin();it!=other.mFileDefines.constEnd();++it)
+        mFileDefines.insert(it.key(), it.value()?std::make_shared<DefineMap>(*it.value()):PDefineMap());
+    for (auto it=other.mFileUndefines.constBegin();it!=other.mFileUndefines.constEnd();++it)
+        mFileUndefines.insert(it.key(), it.value()?std::make_shared<DefineMap>(*it.value()):PDefineMap());
+    mScannedFiles = other.mScannedFiles;
+    mHardDefines = other.mHardDefines;
+    mProjectIncludePaths = other.mProjectIncludePaths;
+    mIncludePathList = other.mIncludePathList;
+    mProjectIncludePathList = other.mProjectIncludePathList;
+    mIncludePaths = other.mIncludePaths;
+    mParseSystem = other.mParseSystem;
+    mParseLocal = other.mParseLocal;
+    mSupportCPP23 = other.mSupportCPP23;
+    mSystemHeaderScanCount = other.mSystemHeaderScanCount;
+}
+
 void CppPreprocessor::clearTempResults()
 {    
     //temporary data when preprocessing single file
@@ -77,6 +103,7 @@ void CppPreprocessor::clearTempResults()
     mBranchResults.clear();// stack of branch results (boolean). last one is current branch, first one is outermost branch
     //mDefines.clear(); // working set, editable
     mProcessed.clear(); // dictionary to save filename already processed
+    mHeaderFileNames.clear();
 }
 
 void CppPreprocessor::addDefineByParts(const QString &name, const QString &args, const QString &value, bool hardCoded)
@@ -272,6 +299,19 @@ void CppPreprocessor::removeScannedFile(const QString &filename)
     mFileUndefines.remove(filename);
 }
 
+void CppPreprocessor::addScannedFile(const PParsedFileInfo &fileInfo, const PDefineMap &defines, const PDefineMap &undefines)
+{
+    if (!fileInfo)
+        return;
+    QString fileName = fileInfo->fileName();
+    mFileInfos.insert(fileName, fileInfo);
+    mScannedFiles.insert(fileName);
+    if (defines && !defines->isEmpty())
+        mFileDefines.insert(fileName, defines);
+    if (undefines && !undefines->isEmpty())
+        mFileUndefines.insert(fileName, undefines);
+}
+
 QString CppPreprocessor::expandMacros(QString text) const
 {
     QSet<QString> dummySet;
@@ -320,6 +360,29 @@ void CppPreprocessor::handleInclude(const QString &tokens, bool fromNext)
     QString fileName;
     // Get full header file name
     QString currentDir = excludeTrailingPathDelimiter(extractFileDir(file->fileName));
+    QString s=tokens;
+    if (!s.startsWith('<') && !s.startsWith('\"'))
+        s = expandMacros(s);
+
+    // the same headers are included many times while preprocessing one file,
+    // don't search include paths on disk again for them
+    QString key = QString("%1\n%2\n%3").arg(currentDir, s, fromNext?"1":"0");
+    auto it = mHeaderFileNames.constFind(key);
+    if (it != mHeaderFileNames.constEnd()) {
+        fileName = it.value();
+    } else {
+        fileName = findHeaderFileName(file->fileName, currentDir, s, fromNext);
+        mHeaderFileNames.insert(key, fileName);
+    }
+
+    if (fileName.isEmpty())
+        return;
+
+    openInclude(fileName);
+}
+
+QString CppPreprocessor::findHeaderFileName(const QString &includingFile, const QString &currentDir, const QString &line, bool fromNext)
+{
     QStringList includes;
     QStringList projectIncludes;
     if (fromNext && mIncludePaths.contains(currentDir)) {
@@ -342,21 +405,11 @@ void CppPreprocessor::handleInclude(const QString &tokens, bool fromNext)
         projectIncludes = mProjectIncludePathList;
     }
 
-    QString s=tokens;
-    if (!s.startsWith('<') && !s.startsWith('\"'))
-        s = expandMacros(s);
-
-    fileName = getHeaderFilename(
-                file->fileName,
-                s,
+    return getHeaderFilename(
+                includingFile,
+                line,
                 includes,
                 projectIncludes);
-
-    if (fileName.isEmpty())
-        return;
-
-    PParsedFileInfo oldCurrentIncludes = mCurrentFileInfo;
-    openInclude(fileName);
 }
 
 void CppPreprocessor::handlePreprocessor(const QString& command, const QString& tokens)
@@ -532,10 +585,15 @@ QString CppPreprocessor::expandMacros(QString text, bool handleBuffer, const QSe
             }
             if (!word.isEmpty()) {
                 QSet<QString> macrosUsed;
-                QSet<QString> ignores=macrosToBeIgnored;
-                foreach(const QString& name, tempIngoreMacros)
-                    ignores.insert(name);
-                QString newWord = expandMacro(text,word,i, handleBuffer,ignores,macrosUsed);
+                QString newWord;
+                if (tempIngoreMacros.isEmpty()) {
+                    newWord = expandMacro(text,word,i, handleBuffer,macrosToBeIgnored,macrosUsed);
+                } else {
+                    QSet<QString> ignores=macrosToBeIgnored;
+                    foreach(const QString& name, tempIngoreMacros)
+                        ignores.insert(name);
+                    newWord = expandMacro(text,word,i, handleBuffer,ignores,macrosUsed);
+                }
                 if (!macrosUsed.isEmpty()) {
                     //adjust ignore macro list
                     QMultiHash<int,QString> tempMacros2 = tempIngoreMacros;
@@ -639,7 +697,7 @@ QString CppPreprocessor::expandMacro(QString &text, const QString &word, int &i,
         return word;
     }
     int lenLine = text.length();
-    PDefine define = getDefine(word);
+    PDefine define = lookupMacro(word);
     if (define && define->args=="" ) {
         macrosUsed.insert(word);
         return define->value;
@@ -708,6 +766,25 @@ QString CppPreprocessor::expandMacro(QString &text, const QString &word, int &i,
     return word;
 }
 
+PDefine CppPreprocessor::lookupMacro(const QString &name)
+{
+    PDefine define = getDefine(name);
+    if (mMacroLookups)
+        mMacroLookups->append(QPair<QString,PDefine>(name,define));
+    return define;
+}
+
+bool CppPreprocessor::isMacroExpansionValid(const MacroExpansion &expansion) const
+{
+    if (getDefine(expansion.define->name)!=expansion.define)
+        return false;
+    foreach (const auto& lookup, expansion.lookups) {
+        if (getDefine(lookup.first)!=lookup.second)
+            return false;
+    }
+    return true;
+}
+
 QString CppPreprocessor::removeGCCAttributes(const QString &line)
 {
     QString newLine = "";
@@ -810,6 +887,8 @@ void CppPreprocessor::openInclude(QString fileName)
 
         // Only load up the file if we are allowed to parse it
         bool isSystemFile = isSystemHeaderFile(fileName, mIncludePaths) || isSystemHeaderFile(fileName, mProjectIncludePaths);
+        if (isSystemFile)
+            mSystemHeaderScanCount++;
         if ((mParseSystem && isSystemFile) || (mParseLocal && !isSystemFile)) {
             QStringList bufferedText;
             if (mOnGetFileStream && mOnGetFileStream(fileName,bufferedText)) {
@@ -1427,7 +1506,39 @@ bool CppPreprocessor::skipParenthesis(const QString &line, int &index, int step)
     return false;
 }
 
+static constexpr int MaxMacroExpansionCacheSize = 20000;
+
 QString CppPreprocessor::expandFunctionLikeMacro(PDefine define, const QString &args, const QSet<QString> &macrosToBeIgnored)
+{
+    if (define->argUsed.length()==0) {
+        QString result = define->formatValue;
+        result.replace("%%","%");
+        return result;
+    }
+    QStringList ignores(macrosToBeIgnored.begin(),macrosToBeIgnored.end());
+    ignores.sort();
+    QString key = QString("%1\n%2\n%3").arg(define->name, args, ignores.join(' '));
+    auto it = mMacroExpansions.constFind(key);
+    if (it!=mMacroExpansions.constEnd() && isMacroExpansionValid(it.value())) {
+        if (mMacroLookups)
+            mMacroLookups->append(it->lookups);
+        return it->result;
+    }
+    MacroLookupList* outerLookups = mMacroLookups;
+    MacroExpansion expansion;
+    expansion.define = define;
+    mMacroLookups = &expansion.lookups;
+    expansion.result = doExpandFunctionLikeMacro(define, args, macrosToBeIgnored);
+    mMacroLookups = outerLookups;
+    if (mMacroLookups)
+        mMacroLookups->append(expansion.lookups);
+    if (mMacroExpansions.count()>=MaxMacroExpansionCacheSize)
+        mMacroExpansions.clear();
+    mMacroExpansions.insert(key, expansion);
+    return expansion.result;
+}
+
+QString CppPreprocessor::doExpandFunctionLikeMacro(PDefine define, const QString &args, const QSet<QString> &macrosToBeIgnored)
 {
     // Replace function by this string
     QString result = define->formatValue;
@@ -46,6 +46,14 @@ struct ParsedFile {
 
 using PParsedFile = std::shared_ptr<ParsedFile>;
 
+using MacroLookupList = QList<QPair<QString,PDefine>>;
+
+struct MacroExpansion {
+    PDefine define;
+    QString result;
+    MacroLookupList lookups; // macros looked up while expanding, with the define found
+};
+
 class CppPreprocessor
 {
     enum class ContentType {
@@ -66,6 +74,12 @@ public:
     CppPreprocessor& operator=(const CppPreprocessor&)=delete;
 
     void clear();
+    /**
+     * @brief copy the results and options of another preprocessor
+     * @param cloneFileInfo returns the copy of a parsed file info
+     */
+    void copyFrom(const CppPreprocessor& other,
+                  const std::function<PParsedFileInfo (const PParsedFileInfo&)>& cloneFileInfo);
 
     void clearTempResults();
     void getDefineParts(const QString& input, QString &name, QString &args, QString &value);
@@ -104,6 +118,10 @@ public:
         return mFileInfos.value(fileName);
     }
 
+    const QHash<QString, PParsedFileInfo>& fileInfos() const {
+        return mFileInfos;
+    }
+
     void removeFileInfo(const QString& fileName) {
         mFileInfos.remove(fileName);
     }
@@ -120,12 +138,35 @@ public:
         return mScannedFiles;
     }
 
+    // increased each time a system header is scanned, it's never reset
+    int systemHeaderScanCount() const {
+        return mSystemHeaderScanCount;
+    }
+
     const QSet<QString> &projectIncludePaths() const {
         return mProjectIncludePaths;
     }
 
     const DefineMap &hardDefines() const { return mHardDefines; }
 
+    PDefineMap fileDefines(const QString& fileName) const {
+        return mFileDefines.value(fileName);
+    }
+
+    PDefineMap fileUndefines(const QString& fileName) const {
+        return mFileUndefines.value(fileName);
+    }
+
+    /**
+     * @brief Register a file scanned in another session (loaded from the parser cache)
+     * @param fileInfo include infos of the file
+     * @param defines macros defined in the file
+     * @param undefines macros undefined in the file
+     */
+    void addScannedFile(const PParsedFileInfo& fileInfo,
+                        const PDefineMap& defines,
+                        const PDefineMap& undefines);
+
     const QList<QString> &includePathList() const { return mIncludePathList; }
 
     const QList<QString> &projectIncludePathList() const { return mProjectIncludePathList; }
@@ -146,6 +187,7 @@ private:
     bool supportCPP23() const;
 
     QString expandFunctionLikeMacro(PDefine define,const QString &args, const QSet<QString> &macrosToBeIgnored);
+    QString doExpandFunctionLikeMacro(PDefine define,const QString &args, const QSet<QString> &macrosToBeIgnored);
     void preprocessBuffer();
     void skipToPreprocessor();
     QString getNextPreprocessor();
@@ -153,6 +195,8 @@ private:
     QString expandMacros(QString text, bool handleBuffer);
     QString expandMacros(QString text, bool handleBuffer, const QSet<QString> macrosToBeIgnored);
     QString expandMacro(QString &text, const QString &word, int &i, bool handleBuffer, const QSet<QString> &macrosToBeIgnored, QSet<QString> &macrosUsed);
+    PDefine lookupMacro(const QString& name);
+    bool isMacroExpansionValid(const MacroExpansion& expansion) const;
 
     void handleDefine(const QString& tokens);
     void handleUndefine(const QString& tokens);
@@ -168,6 +212,7 @@ private:
     void handleIncludeNext(const QString& tokens);
 
     void handleInclude(const QString& line, bool fromNext);
+    QString findHeaderFileName(const QString& includingFile, const QString& currentDir, const QString& line, bool fromNext);
     void handlePreprocessor(const QString& command, const QString& tokens);
     QString removeGCCAttributes(const QString& line);
     void removeGCCAttribute(const QString&line, QString& newLine, int &i, const QString& word);
@@ -294,6 +339,12 @@ private:
     QList<BranchResult> mBranchResults;// stack of branch results (boolean). last one is current branch, first one is outermost branch
     DefineMap mDefines; // working set, editable
     QSet<QString> mProcessed; // dictionary to save filename already processed
+    QHash<QString, QString> mHeaderFileNames; // resolved header file names of #include lines, keyed by dir and line
+
+    //function-like macro expansions, keyed by macro name, args and ignored macros.
+    //an entry is reused only if all macros it looked up still resolve to the same defines
+    QHash<QString, MacroExpansion> mMacroExpansions;
+    MacroLookupList* mMacroLookups; // where lookups of the running expansion are recorded
 
 
     //Result across processings.
@@ -318,6 +369,7 @@ private:
     bool mParseSystem;
     bool mParseLocal;
     bool mSupportCPP23;
+    int mSystemHeaderScanCount;
 
     GetFileStreamFunc mOnGetFileStream;
 };
@@ -21,7 +21,12 @@
 #include <QDebug>
 
 CppTokenizer::CppTokenizer():
-mLastTokenType{TokenType::None}
+mStart{nullptr},
+mCurrent{nullptr},
+mLineCount{nullptr},
+mCurrentLine{0},
+mLastTokenType{TokenType::None},
+mHasUnmatchedPairs{false}
 {
 }
 
@@ -36,6 +41,7 @@ void CppTokenizer::clear()
     mUnmatchedBrackets.clear();
     mUnmatchedParenthesis.clear();
     mLambdas.clear();
+    mHasUnmatchedPairs = false;
 }
 
 void CppTokenizer::tokenize(const QStringList &buffer)
@@ -69,6 +75,10 @@ void CppTokenizer::tokenize(const QStringList &buffer)
         else
             addToken(s,mCurrentLine,tokenType);
     }
+    if (!mUnmatchedBraces.isEmpty()
+            || !mUnmatchedBrackets.isEmpty()
+            || !mUnmatchedParenthesis.isEmpty())
+        mHasUnmatchedPairs = true;
     while (!mUnmatchedBraces.isEmpty()) {
         addToken("}",mCurrentLine,TokenType::RightBrace);
     }
@@ -80,6 +90,24 @@ void CppTokenizer::tokenize(const QStringList &buffer)
     }
 }
 
+void CppTokenizer::swap(CppTokenizer &other)
+{
+    std::swap(mBuffer, other.mBuffer);
+    std::swap(mBufferStr, other.mBufferStr);
+    std::swap(mStart, other.mStart);
+    std::swap(mCurrent, other.mCurrent);
+    std::swap(mLineCount, other.mLineCount);
+    std::swap(mCurrentLine, other.mCurrentLine);
+    std::swap(mLastToken, other.mLastToken);
+    std::swap(mLastTokenType, other.mLastTokenType);
+    std::swap(mTokenList, other.mTokenList);
+    std::swap(mLambdas, other.mLambdas);
+    std::swap(mUnmatchedBraces, other.mUnmatchedBraces);
+    std::swap(mUnmatchedBrackets, other.mUnmatchedBrackets);
+    std::swap(mUnmatchedParenthesis, other.mUnmatchedParenthesis);
+    std::swap(mHasUnmatchedPairs, other.mHasUnmatchedPairs);
+}
+
 void CppTokenizer::dumpTokens(const QString &fileName)
 {
     QFile file(fileName);
@@ -108,6 +136,7 @@ void CppTokenizer::addToken(const QString &sText, int iLine, TokenType tokenType
     case TokenType::RightBrace:
         if (mUnmatchedBraces.isEmpty()) {
             token->matchIndex=-1;
+            mHasUnmatchedPairs = true;
         } else {
             token->matchIndex = mUnmatchedBraces.last();
             mTokenList[token->matchIndex]->matchIndex=mTokenList.count();
@@ -121,6 +150,7 @@ void CppTokenizer::addToken(const QString &sText, int iLine, TokenType tokenType
     case TokenType::RightBracket:
         if (mUnmatchedBrackets.isEmpty()) {
             token->matchIndex=-1;
+            mHasUnmatchedPairs = true;
         } else {
             token->matchIndex = mUnmatchedBrackets.last();
             mTokenList[token->matchIndex]->matchIndex=mTokenList.count();
@@ -134,6 +164,7 @@ void CppTokenizer::addToken(const QString &sText, int iLine, TokenType tokenType
     case TokenType::RightParenthesis:
         if (mUnmatchedParenthesis.isEmpty()) {
             token->matchIndex=-1;
+            mHasUnmatchedPairs = true;
         } else {
             token->matchIndex = mUnmatchedParenthesis.last();
             mTokenList[token->matchIndex]->matchIndex=mTokenList.count();
@@ -50,10 +50,13 @@ public:
 
     void clear();
     void tokenize(const QStringList& buffer);
+    void swap(CppTokenizer& other);
     void dumpTokens(const QString& fileName);
     const PToken& operator[](int i) const { return mTokenList[i]; }
     int tokenCount() const { return mTokenList.count(); }
     static bool isIdentChar(const QChar& ch) { return ch=='_' || ch.isLetter(); }
+    // some braces/brackets/parenthesis are not paired in the tokenized buffer
+    bool hasUnmatchedPairs() const { return mHasUnmatchedPairs; }
     int lambdasCount() const { return mLambdas.count(); }
 
     int indexOfFirstLambda() const { return mLambdas.front(); }
@@ -159,6 +162,7 @@ private:
     QVector<int> mUnmatchedBraces; // stack of indices for unmatched '{'
     QVector<int> mUnmatchedBrackets; // stack of indices for unmatched '['
     QVector<int> mUnmatchedParenthesis;// stack of indices for unmatched '('
+    bool mHasUnmatchedPairs;
 };
 
 using PCppTokenizer = std::shared_ptr<CppTokenizer>;
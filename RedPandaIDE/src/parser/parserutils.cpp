@@ -587,6 +587,43 @@ void CppScopes::addScope(int line, PStatement scopeStatement)
 #endif
 }
 
+CppScopes CppScopes::clone(const StatementMapper &mapStatement) const
+{
+    CppScopes result;
+    result.mScopes.reserve(mScopes.size());
+    foreach (const PCppScope& scope, mScopes) {
+        PCppScope newScope = std::make_shared<CppScope>();
+        newScope->startLine = scope->startLine;
+        newScope->statement = mapStatement(scope->statement);
+        result.mScopes.append(newScope);
+    }
+    return result;
+}
+
+std::shared_ptr<ParsedFileInfo> ParsedFileInfo::clone(const StatementMapper &mapStatement) const
+{
+    std::shared_ptr<ParsedFileInfo> result = std::make_shared<ParsedFileInfo>(mFileName);
+    result->mIncludes = mIncludes;
+    result->mDirectIncludes = mDirectIncludes;
+    result->mUsings = mUsings;
+    for (auto it=mStatements.constBegin();it!=mStatements.constEnd();++it)
+        result->mStatements.insert(it.key(), mapStatement(it.value()));
+    result->mScopes = mScopes.clone(mapStatement);
+    result->mBranches = mBranches;
+    result->mHandledInheritances = mHandledInheritances;
+    return result;
+}
+
+QVector<PCppScope> CppScopes::takeScopesAfter(int line)
+{
+    int i=mScopes.size();
+    while (i>0 && mScopes[i-1]->startLine>line)
+        i--;
+    QVector<PCppScope> result = mScopes.mid(i);
+    mScopes.resize(i);
+    return result;
+}
+
 MemberOperatorType getOperatorType(const QString &phrase, int index)
 {
     if (index>=phrase.length())
@@ -766,3 +803,95 @@ bool ParsedFileInfo::isLineVisible(int line) const
     }
     return lastI<0?true:mBranches[lastI];
 }
+
+void ParsedFileInfo::shiftLines(int fromLine, int delta)
+{
+    // a statement may be added more than once
+    QSet<const Statement*> shifted;
+    foreach (const PStatement& statement, mStatements) {
+        if (shifted.contains(statement.get()))
+            continue;
+        shifted.insert(statement.get());
+        if (statement->fileName == mFileName && statement->line >= fromLine)
+            statement->line += delta;
+        if (statement->definitionFileName == mFileName && statement->definitionLine >= fromLine)
+            statement->definitionLine += delta;
+    }
+    QMap<int,bool> branches;
+    for (auto it=mBranches.constBegin();it!=mBranches.constEnd();++it) {
+        int line = it.key();
+        branches.insert(line>=fromLine?line+delta:line, it.value());
+    }
+    mBranches = branches;
+}
+
+StringPool::StringPool():
+    mPrunedCount{0}
+{
+
+}
+
+QString StringPool::intern(const QString &s)
+{
+    if (s.isEmpty())
+        return QString();
+    auto it = mStrings.constFind(s);
+    if (it!=mStrings.constEnd())
+        return *it;
+    QString result = s;
+    result.squeeze();
+    mStrings.insert(result);
+    return result;
+}
+
+void StringPool::internStatementStrings(Statement &statement)
+{
+    statement.type = intern(statement.type);
+    statement.args = intern(statement.args);
+    statement.noNameArgs = intern(statement.noNameArgs);
+    statement.templateSpecializationParams = intern(statement.templateSpecializationParams);
+    statement.fileName = intern(statement.fileName);
+    statement.definitionFileName = intern(statement.definitionFileName);
+}
+
+int StringPool::count() const
+{
+    return mStrings.count();
+}
+
+void StringPool::clear()
+{
+    mStrings.clear();
+    mPrunedCount = 0;
+}
+
+bool StringPool::shouldPrune() const
+{
+    return mStrings.count() > 2 * mPrunedCount + 1000;
+}
+
+void StringPool::prune(const QList<PStatement> &usedStatements)
+{
+    // Rebuild the pool instead of checking the reference counts of its strings,
+    // the counts also include copies held by read snapshots, caches and other threads.
+    QSet<QString> strings;
+    foreach (const PStatement& statement, usedStatements) {
+        keep(strings, statement->type);
+        keep(strings, statement->args);
+        keep(strings, statement->noNameArgs);
+        keep(strings, statement->templateSpecializationParams);
+        keep(strings, statement->fileName);
+        keep(strings, statement->definitionFileName);
+    }
+    mStrings = strings;
+    mPrunedCount = mStrings.count();
+}
+
+void StringPool::keep(QSet<QString> &strings, const QString &s) const
+{
+    if (s.isEmpty())
+        return;
+    // keep the pooled copy, so later interned strings share it with the statements
+    auto it = mStrings.constFind(s);
+    strings.insert(it!=mStrings.constEnd()?*it:s);
+}
@@ -173,7 +173,8 @@ enum class StatementProperty {
     Constexpr =           0x0080,
     FunctionPointer =     0x0100,
     OperatorOverloading = 0x0200,
-    DummyStatement     =  0x0400
+    DummyStatement     =  0x0400,
+    ReadOnly =            0x0800 // shared by parsers, don't modify it
 };
 
 Q_DECLARE_FLAGS(StatementProperties, StatementProperty)
@@ -187,6 +188,8 @@ using PStatement = std::shared_ptr<Statement>;
 using StatementList = QList<PStatement>;
 using PStatementList = std::shared_ptr<StatementList>;
 using StatementMap = QMultiMap<QString, PStatement>;
+// maps a statement to its counterpart in a copied statement tree
+using StatementMapper = std::function<PStatement (const PStatement&)>;
 struct Statement {
     std::weak_ptr<Statement> parentScope; // parent class/struct/namespace scope, use weak pointer to prevent circular reference
     QString type; // type "int"
@@ -247,6 +250,13 @@ struct Statement {
     bool isInherited() {
         return properties.testFlag(StatementProperty::Inherited);
     } // inherted member;
+    // statement shared by parsers (system header snapshot)
+    bool isReadOnly() {
+        return properties.testFlag(StatementProperty::ReadOnly);
+    }
+    void setReadOnly(bool on) {
+        properties.setFlag(StatementProperty::ReadOnly, on);
+    }
 
 };
 
@@ -308,6 +318,10 @@ public:
             mScopes.pop_back();
     }
     void clear() { mScopes.clear(); }
+    const QVector<PCppScope>& scopes() const { return mScopes; }
+    CppScopes clone(const StatementMapper& mapStatement) const;
+    QVector<PCppScope> takeScopesAfter(int line);
+    void appendScopes(const QVector<PCppScope>& scopes) { mScopes.append(scopes); }
 private:
     QVector<PCppScope> mScopes;
 };
@@ -327,9 +341,10 @@ using PClassInheritanceInfo = std::shared_ptr<ClassInheritanceInfo>;
 
 class ParsedFileInfo {
 public:
-    ParsedFileInfo(const QString& fileName): mFileName {fileName} { }
+    ParsedFileInfo(const QString& fileName): mFileName {fileName}, mReadOnly {false} { }
     ParsedFileInfo(const ParsedFileInfo&)=delete;
     ParsedFileInfo& operator=(const ParsedFileInfo&)=delete;
+    std::shared_ptr<ParsedFileInfo> clone(const StatementMapper& mapStatement) const;
     void insertBranch(int level, bool branchTrue) { mBranches.insert(level, branchTrue); }
     bool isLineVisible(int line) const;
     void addInclude(const QString &fileName) { mIncludes.insert(fileName); }
@@ -337,13 +352,21 @@ public:
     bool including(const QString &fileName) const { return mIncludes.contains(fileName); }
     PStatement findScopeAtLine(int line) const { return mScopes.findScopeAtLine(line); }
     void addStatement(const PStatement &statement) { mStatements.insert(statement->fullName,statement); }
+    void removeStatement(const PStatement &statement) { mStatements.remove(statement->fullName,statement); }
     void clearStatements() { mStatements.clear(); }
     void addScope(int line, const PStatement &scope) { mScopes.addScope(line,scope); }
     void removeLastScope() { mScopes.removeLastScope(); }
+    QVector<PCppScope> takeScopesAfter(int line) { return mScopes.takeScopesAfter(line); }
+    void appendScopes(const QVector<PCppScope>& scopes) { mScopes.appendScopes(scopes); }
+    // move statements and branches at or after fromLine by delta lines (scopes are not moved)
+    void shiftLines(int fromLine, int delta);
     PStatement lastScope() const { return mScopes.lastScope(); }
     void addUsing(const QString &usingSymbol) { mUsings.insert(usingSymbol); }
     void addHandledInheritances(std::weak_ptr<ClassInheritanceInfo> classInheritanceInfo) { mHandledInheritances.append(classInheritanceInfo); }
     void clearHandledInheritances() { mHandledInheritances.clear(); }
+    // infos loaded from the system header cache are shared by all parsers
+    bool isReadOnly() const { return mReadOnly; }
+    void setReadOnly(bool on) { mReadOnly = on; }
 
     QString fileName() const { return mFileName; }
     const StatementMap& statements() const { return mStatements; }
@@ -351,6 +374,8 @@ public:
     const QStringList& directIncludes() const { return mDirectIncludes; }
     const QSet<QString>& includes() const { return mIncludes; }
     const QList<std::weak_ptr<ClassInheritanceInfo> >& handledInheritances() const { return mHandledInheritances; }
+    const CppScopes& scopes() const { return mScopes; }
+    const QMap<int,bool>& branches() const { return mBranches; }
 
 private:
     QString mFileName;
@@ -361,10 +386,31 @@ private:
     CppScopes mScopes; // int is start line of the statement scope
     QMap<int,bool> mBranches;
     QList<std::weak_ptr<ClassInheritanceInfo>> mHandledInheritances;
+    bool mReadOnly;
 };
 
 using PParsedFileInfo = std::shared_ptr<ParsedFileInfo>;
 
+// Keeps one shared copy of strings that repeat across statements
+// (types, file names, argument lists), relying on QString's implicit sharing.
+class StringPool {
+public:
+    StringPool();
+    QString intern(const QString& s);
+    void internStatementStrings(Statement& statement);
+    int count() const;
+    void clear();
+    // the pool has grown enough since the last prune() to be worth pruning
+    bool shouldPrune() const;
+    // keep only the strings used by the given statements
+    void prune(const QList<PStatement>& usedStatements);
+private:
+    void keep(QSet<QString>& strings, const QString& s) const;
+private:
+    QSet<QString> mStrings;
+    int mPrunedCount;
+};
+
 extern QStringList CppDirectives;
 extern QStringList JavadocTags;
 extern QMap<QString,KeywordType> CppKeywords;
@@ -31,7 +31,10 @@ void StatementModel::add(const PStatement& statement)
     }
     PStatement parent = statement->parentScope.lock();
     if (parent) {
-        addMember(parent->children,statement);
+        // children of shared statements can't be changed,
+        // the statement is only found by its file info and scopes
+        if (!parent->isReadOnly())
+            addMember(parent->children,statement);
     } else {
         addMember(mGlobalStatements,statement);
     }
@@ -41,6 +44,29 @@ void StatementModel::add(const PStatement& statement)
 #endif
 }
 
+void StatementModel::addReadOnlyStatements(const QVector<PStatement> &statements)
+{
+    foreach (const PStatement& statement, statements) {
+        if (statement->parentScope.expired())
+            addMember(mGlobalStatements,statement);
+        mCount++;
+#ifdef QT_DEBUG
+        mAllStatements.append(statement);
+#endif
+    }
+}
+
+void StatementModel::copyFrom(const StatementModel &model, const StatementMapper &mapStatement)
+{
+    clear();
+    // QMultiMap::insert() puts newer items before older ones with the same key
+    for (auto it=model.mGlobalStatements.constEnd();it!=model.mGlobalStatements.constBegin();) {
+        --it;
+        mGlobalStatements.insert(it.key(), mapStatement(it.value()));
+    }
+    mCount = model.mCount;
+}
+
 void StatementModel::deleteStatement(const PStatement& statement)
 {
     if (!statement) {
@@ -49,7 +75,11 @@ void StatementModel::deleteStatement(const PStatement& statement)
     PStatement parent = statement->parentScope.lock();
     int count = 0;
     if (parent) {
-        count = deleteMember(parent->children,statement);
+        // statements of shared parents are not in their children
+        if (parent->isReadOnly())
+            count = 1;
+        else
+            count = deleteMember(parent->children,statement);
     } else {
         count = deleteMember(mGlobalStatements,statement);
     }
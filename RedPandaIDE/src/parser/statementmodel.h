@@ -30,7 +30,17 @@ public:
     StatementModel& operator=(const StatementModel&)=delete;
 
     void add(const PStatement& statement);
+    /**
+     * @brief add statements of a shared system header snapshot
+     * Children lists of these statements are already set and shouldn't be modified.
+     */
+    void addReadOnlyStatements(const QVector<PStatement>& statements);
     void deleteStatement(const PStatement& statement);
+    /**
+     * @brief copy the top level statements of another model
+     * Children of the mapped statements should be set by the caller.
+     */
+    void copyFrom(const StatementModel& model, const StatementMapper& mapStatement);
     const StatementMap& childrenStatements(const PStatement& statement = PStatement()) const {
         if (!statement) {
             return mGlobalStatements;
@@ -16,18 +16,27 @@
  */
 #include "ojproblemset.h"
 
+#include <QFile>
 #include <QUuid>
 
 OJProblemCase::OJProblemCase(QObject *parent):
     QObject{parent},
     mModified{false},
     testState{ProblemCaseTestState::NotTested},
+    outputHeadLineCounts{-1},
+    outputTailLineCounts{0},
     firstDiffLine{-1}
 {
     QUuid uid = QUuid::createUuid();
     mId = uid.toString();
 }
 
+OJProblemCase::~OJProblemCase()
+{
+    if (!outputFileName.isEmpty())
+        QFile::remove(outputFileName);
+}
+
 const QString &OJProblemCase::name() const
 {
     return mName;
@@ -44,6 +44,7 @@ class  OJProblemCase : public QObject{
 public:
     explicit OJProblemCase(QObject* parent = nullptr);
     OJProblemCase(const OJProblemCase &) = delete;
+    ~OJProblemCase();
     const QString &id() const;
 
     const QString &name() const;
@@ -73,6 +74,9 @@ private:
 public:
     ProblemCaseTestState testState; // no persistence
     QString output; // no persistence
+    QString outputFileName; // no persistence, the whole output when it's saved to a file (output is only a preview)
+    int outputHeadLineCounts; // no persistence, lines before the omitted part of the preview, -1 if nothing is omitted
+    int outputTailLineCounts; // no persistence, lines after the omitted part of the preview
     qulonglong runningTime; // no persistence
     qulonglong runningMemory; // no persistence;
     int outputLineCounts; // no persistence;
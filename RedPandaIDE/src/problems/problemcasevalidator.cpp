@@ -15,95 +15,218 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "problemcasevalidator.h"
+#include <QFile>
+#include <memory>
+#include <qt_utils/charsetinfo.h>
 
-ProblemCaseValidator::ProblemCaseValidator()
-{
+namespace {
 
-}
+// Reads lines one at a time. A line is valid until the next read.
+class LineReader
+{
+public:
+    virtual ~LineReader() = default;
+    // returns false if there are no more lines
+    virtual bool readLine(QStringView& line) = 0;
+    // skips and counts the lines not read yet
+    virtual int countRemainingLines() {
+        QStringView line;
+        int count = 0;
+        while (readLine(line))
+            count++;
+        return count;
+    }
+    // the content can't be decoded by the reader's encoding
+    virtual bool hasDecodeError() const { return false; }
+};
 
-bool ProblemCaseValidator::validate(POJProblemCase problemCase, ProblemCaseValidateType type)
+// Splits lines the same way as textToLines()
+class StringLineReader : public LineReader
 {
-    if (!problemCase)
-        return false;
-    QStringList output = textToLines(problemCase->output);
-    QStringList expected;
-    if (fileExists(problemCase->expectedOutputFileName()))
-        expected = readFileToLines(problemCase->expectedOutputFileName());
-    else
-        expected = textToLines(problemCase->expected());
-    problemCase->outputLineCounts = output.count();
-    problemCase->expectedLineCounts = expected.count();
-    if (expected.count() > 5000) {
-        if (output.count()<expected.count()) {
-            problemCase->firstDiffLine=output.count();
+public:
+    explicit StringLineReader(const QString& text):
+        mText{text},
+        mPos{0}
+    {
+    }
+
+    bool readLine(QStringView& line) override {
+        if (mPos >= mText.length())
             return false;
-        }  else if (output.count()>expected.count()) {
-            problemCase->firstDiffLine=expected.count();
+        int end = mText.indexOf('\n', mPos);
+        if (end < 0)
+            end = mText.length();
+        line = QStringView{mText}.mid(mPos, end - mPos);
+        if (line.endsWith('\r'))
+            line.chop(1);
+        mPos = end + 1;
+        return true;
+    }
+private:
+    const QString& mText;
+    int mPos;
+};
+
+// Splits and decodes lines the same way as readFileToLines()
+class FileLineReader : public LineReader
+{
+public:
+    FileLineReader(const QString& fileName, TextDecoder&& decoder):
+        mFile{fileName},
+        mDecoder{std::move(decoder)},
+        mDecodeError{false}
+    {
+        if (mDecoder.isValid())
+            mFile.open(QFile::ReadOnly);
+    }
+
+    bool readLine(QStringView& line) override {
+        if (!mFile.isOpen() || mFile.atEnd())
             return false;
+        QByteArray bytes = mFile.readLine();
+        if (bytes.endsWith('\n'))
+            bytes.chop(1);
+        if (bytes.endsWith('\r'))
+            bytes.chop(1);
+        auto [ok, decoded] = mDecoder.decode(bytes);
+        if (!ok)
+            mDecodeError = true;
+        mLine = decoded;
+        line = mLine;
+        return true;
+    }
+
+    int countRemainingLines() override {
+        if (!mFile.isOpen())
+            return 0;
+        // line breaks are counted without decoding
+        int count = 0;
+        char lastChar = '\n';
+        while (true) {
+            QByteArray buffer = mFile.read(64*1024);
+            if (buffer.isEmpty())
+                break;
+            count += buffer.count('\n');
+            lastChar = buffer.at(buffer.length()-1);
         }
+        if (lastChar != '\n')
+            count++;
+        return count;
     }
-    int count=std::min(output.count(), expected.count());
-    switch(type) {
-    case ProblemCaseValidateType::Exact:
-        for (int i=0;i<count;i++) {
-            if (output[i]!=expected[i]) {
-                problemCase->firstDiffLine = i;
+
+    bool hasDecodeError() const override { return mDecodeError; }
+private:
+    QFile mFile;
+    TextDecoder mDecoder;
+    bool mDecodeError;
+    QString mLine;
+};
+
+bool equalIgnoringSpaces(QStringView s1, QStringView s2)
+{
+    // compare token by token, without splitting the lines
+    int i = 0;
+    int j = 0;
+    while (true) {
+        while (i < s1.length() && s1[i].isSpace())
+            i++;
+        while (j < s2.length() && s2[j].isSpace())
+            j++;
+        if (i == s1.length() || j == s2.length())
+            return i == s1.length() && j == s2.length();
+        while (i < s1.length() && j < s2.length()
+               && !s1[i].isSpace() && !s2[j].isSpace()) {
+            if (s1[i] != s2[j])
                 return false;
-            }
+            i++;
+            j++;
         }
-        break;
+        bool tokenEnded1 = (i == s1.length() || s1[i].isSpace());
+        bool tokenEnded2 = (j == s2.length() || s2[j].isSpace());
+        if (!tokenEnded1 || !tokenEnded2)
+            return false;
+    }
+}
+
+bool linesEqual(QStringView s1, QStringView s2, ProblemCaseValidateType type)
+{
+    switch(type) {
+    case ProblemCaseValidateType::Exact:
+        return s1 == s2;
     case ProblemCaseValidateType::IgnoreLeadingTrailingSpaces:
-        for (int i=0;i<count;i++) {
-            if (output[i].trimmed()!=expected[i].trimmed()) {
-                problemCase->firstDiffLine = i;
-                return false;
-            }
-        }
-        break;
+        return s1.trimmed() == s2.trimmed();
     case ProblemCaseValidateType::IgnoreSpaces:
-        for (int i=0;i<count;i++) {
-            if (!equalIgnoringSpaces(output[i],expected[i])) {
-                problemCase->firstDiffLine = i;
-                return false;
-            }
-        }
-        break;
+        return equalIgnoringSpaces(s1, s2);
     }
-    if (output.count()<expected.count()) {
-        problemCase->firstDiffLine=output.count();
-        return false;
-    }  else if (output.count()>expected.count()) {
-        problemCase->firstDiffLine=expected.count();
-        return false;
+    return false;
+}
+
+// Compares until the first different line, and counts lines of both sides
+void compareLines(LineReader& output, LineReader& expected,
+                  ProblemCaseValidateType type, POJProblemCase problemCase)
+{
+    problemCase->outputLineCounts = 0;
+    problemCase->expectedLineCounts = 0;
+    problemCase->firstDiffLine = -1;
+    QStringView outputLine;
+    QStringView expectedLine;
+    while (true) {
+        bool hasOutput = output.readLine(outputLine);
+        bool hasExpected = expected.readLine(expectedLine);
+        if (hasOutput)
+            problemCase->outputLineCounts++;
+        if (hasExpected)
+            problemCase->expectedLineCounts++;
+        if (!hasOutput && !hasExpected)
+            return;
+        if (!hasOutput) {
+            problemCase->firstDiffLine = problemCase->outputLineCounts;
+            break;
+        } else if (!hasExpected) {
+            problemCase->firstDiffLine = problemCase->expectedLineCounts;
+            break;
+        } else if (!linesEqual(outputLine, expectedLine, type)) {
+            problemCase->firstDiffLine = problemCase->outputLineCounts - 1;
+            break;
+        }
     }
-    return true;
+    problemCase->outputLineCounts += output.countRemainingLines();
+    problemCase->expectedLineCounts += expected.countRemainingLines();
+}
+
+std::unique_ptr<LineReader> createOutputReader(POJProblemCase problemCase)
+{
+    // the output is decoded the same way as the runner does (QString::fromLocal8Bit)
+    if (!problemCase->outputFileName.isEmpty())
+        return std::make_unique<FileLineReader>(problemCase->outputFileName, TextDecoder::decoderForSystem());
+    return std::make_unique<StringLineReader>(problemCase->output);
+}
+
 }
 
-bool ProblemCaseValidator::equalIgnoringSpaces(const QString &s1, const QString &s2)
+ProblemCaseValidator::ProblemCaseValidator()
 {
-    QStringList strList1=split(s1);
-    QStringList strList2=split(s2);
-    return (strList1==strList2);
+
 }
 
-QStringList ProblemCaseValidator::split(const QString &s)
+bool ProblemCaseValidator::validate(POJProblemCase problemCase, ProblemCaseValidateType type)
 {
-    QStringList result;
-    const QChar* p = getNullTerminatedStringData(s);
-    const QChar* start = p;
-    while (p->unicode()!=0) {
-        if (p->isSpace()) {
-            if (!start->isSpace()) {
-                result.append(QString(start,p-start));
-            }
-            start = p;
-        } else if (start->isSpace()) {
-            start = p;
+    if (!problemCase)
+        return false;
+    if (fileExists(problemCase->expectedOutputFileName())) {
+        // use the system encoding if the file is not utf-8, as readFileToLines() does
+        QList<QByteArray> encodings{ENCODING_UTF8, pCharsetInfoManager->getDefaultSystemEncoding()};
+        foreach (const QByteArray& encoding, encodings) {
+            std::unique_ptr<LineReader> output = createOutputReader(problemCase);
+            FileLineReader expected{problemCase->expectedOutputFileName(), TextDecoder{encoding}};
+            compareLines(*output, expected, type, problemCase);
+            if (!expected.hasDecodeError())
+                break;
         }
-        p++;
-    }
-    if (!start->isSpace()) {
-        result.append(QString(start,p-start));
+    } else {
+        std::unique_ptr<LineReader> output = createOutputReader(problemCase);
+        StringLineReader expected{problemCase->expected()};
+        compareLines(*output, expected, type, problemCase);
     }
-    return result;
+    return problemCase->firstDiffLine == -1;
 }
@@ -20,14 +20,17 @@
 #include "ojproblemset.h"
 #include "../utils.h"
 
+/**
+ * @brief Compares the output of a problem case with its expected output.
+ *
+ * Both sides are read line by line and compared in place, so memory usage
+ * doesn't grow with the size of the output.
+ */
 class ProblemCaseValidator
 {
 public:
     ProblemCaseValidator();
     bool validate(POJProblemCase problemCase, ProblemCaseValidateType type);
-private:
-    bool equalIgnoringSpaces(const QString& s1, const QString& s2);
-    QStringList split(const QString& s);
 };
 
 #endif // PROBLEMCASEVALIDATOR_H
@@ -72,6 +72,16 @@ void CodeCompletionSettings::setShareParser(bool newShareParser)
     mShareParser = newShareParser;
 }
 
+bool CodeCompletionSettings::cacheSystemHeaders() const
+{
+    return mCacheSystemHeaders;
+}
+
+void CodeCompletionSettings::setCacheSystemHeaders(bool newCacheSystemHeaders)
+{
+    mCacheSystemHeaders = newCacheSystemHeaders;
+}
+
 bool CodeCompletionSettings::hideSymbolsStartsWithUnderLine() const
 {
     return mHideSymbolsStartsWithUnderLine;
@@ -189,6 +199,7 @@ void CodeCompletionSettings::doSave()
     saveValue("hide_symbols_start_with_two_underline", mHideSymbolsStartsWithTwoUnderLine);
     saveValue("hide_symbols_start_with_underline", mHideSymbolsStartsWithUnderLine);
     saveValue("share_parser",mShareParser);
+    saveValue("cache_system_headers",mCacheSystemHeaders);
 }
 
 
@@ -212,4 +223,5 @@ void CodeCompletionSettings::doLoad()
     bool shouldShare= true;
     mShareParser = boolValue("share_parser",shouldShare);
     mClearWhenEditorHidden = boolValue("clear_when_editor_hidden", false);
+    mCacheSystemHeaders = boolValue("cache_system_headers", true);
 }
@@ -68,6 +68,9 @@ public:
     bool shareParser() const;
     void setShareParser(bool newShareParser);
 
+    bool cacheSystemHeaders() const;
+    void setCacheSystemHeaders(bool newCacheSystemHeaders);
+
 private:
     int mWidthInColumns;
     int mHeightInLines;
@@ -84,6 +87,7 @@ private:
     bool mHideSymbolsStartsWithUnderLine;
     bool mClearWhenEditorHidden;
     bool mShareParser;
+    bool mCacheSystemHeaders;
 
     // _Base interface
 protected:
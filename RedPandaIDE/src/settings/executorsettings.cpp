@@ -133,6 +133,16 @@ void ExecutorSettings::setRedirectStderrToToolLog(bool newRedirectStderrToToolLo
     mRedirectStderrToToolLog = newRedirectStderrToToolLog;
 }
 
+bool ExecutorSettings::redirectCaseOutputToFile() const
+{
+    return mRedirectCaseOutputToFile;
+}
+
+void ExecutorSettings::setRedirectCaseOutputToFile(bool newRedirectCaseOutputToFile)
+{
+    mRedirectCaseOutputToFile = newRedirectCaseOutputToFile;
+}
+
 ProblemCaseValidateType ExecutorSettings::problemCaseValidateType() const
 {
     return mProblemCaseValidateType;
@@ -163,6 +173,16 @@ void ExecutorSettings::setMaxCaseInputFileSize(qint64 newMaxCaseInputFileSize)
     mMaxCaseInputFileSize = newMaxCaseInputFileSize;
 }
 
+int ExecutorSettings::caseConcurrency() const
+{
+    return mCaseConcurrency;
+}
+
+void ExecutorSettings::setCaseConcurrency(int newCaseConcurrency)
+{
+    mCaseConcurrency = newCaseConcurrency;
+}
+
 bool ExecutorSettings::convertHTMLToTextForInput() const
 {
     return mConvertHTMLToTextForInput;
@@ -242,6 +262,7 @@ void ExecutorSettings::doSave()
     saveValue("expected_convert_html", mConvertHTMLToTextForExpected);
     saveValue("problem_case_validate_type", (int)mProblemCaseValidateType);
     saveValue("redirect_stderr_to_toollog", mRedirectStderrToToolLog);
+    saveValue("redirect_case_output_to_file", mRedirectCaseOutputToFile);
     saveValue("case_editor_font_name",mCaseEditorFontName);
     saveValue("case_editor_font_size",mCaseEditorFontSize);
     saveValue("case_editor_font_only_monospaced",mCaseEditorFontOnlyMonospaced);
@@ -250,6 +271,7 @@ void ExecutorSettings::doSave()
     remove("case_timeout");
     saveValue("enable_case_limit", mEnableCaseLimit);
     saveValue("case_max_input_file_size",mMaxCaseInputFileSize);
+    saveValue("case_concurrency",mCaseConcurrency);
 }
 
 bool ExecutorSettings::pauseConsole() const
@@ -281,6 +303,7 @@ void ExecutorSettings::doLoad()
     mConvertHTMLToTextForExpected = boolValue("expected_convert_html", false);
     mProblemCaseValidateType =(ProblemCaseValidateType)intValue("problem_case_validate_type", (int)ProblemCaseValidateType::Exact);
     mRedirectStderrToToolLog = boolValue("redirect_stderr_to_toollog", false);
+    mRedirectCaseOutputToFile = boolValue("redirect_case_output_to_file", false);
 
     mCaseEditorFontName = stringValue("case_editor_font_name", defaultMonoFont());
     mCaseEditorFontSize = intValue("case_editor_font_size",11);
@@ -295,4 +318,5 @@ void ExecutorSettings::doLoad()
     mEnableCaseLimit = boolValue("enable_case_limit", true);
 
     mMaxCaseInputFileSize = uintValue("case_max_input_file_size", 4); //4mb
+    mCaseConcurrency = intValue("case_concurrency", 0); //count of cpu cores
 }
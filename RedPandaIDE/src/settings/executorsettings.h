@@ -76,6 +76,9 @@ public:
     bool redirectStderrToToolLog() const;
     void setRedirectStderrToToolLog(bool newRedirectStderrToToolLog);
 
+    bool redirectCaseOutputToFile() const;
+    void setRedirectCaseOutputToFile(bool newRedirectCaseOutputToFile);
+
     ProblemCaseValidateType problemCaseValidateType() const;
     void setProblemCaseValidateType(ProblemCaseValidateType newProblemCaseValidateType);
 
@@ -84,6 +87,10 @@ public:
     qint64 maxCaseInputFileSize() const;
     void setMaxCaseInputFileSize(qint64 newMaxCaseInputFileSize);
 
+    // 0 means the count of cpu cores
+    int caseConcurrency() const;
+    void setCaseConcurrency(int newCaseConcurrency);
+
 private:
     // general
     bool mPauseConsole;
@@ -103,6 +110,7 @@ private:
     bool mIgnoreSpacesWhenValidatingCases;
     ProblemCaseValidateType mProblemCaseValidateType;
     bool mRedirectStderrToToolLog;
+    bool mRedirectCaseOutputToFile;
     QString mCaseEditorFontName;
     int mCaseEditorFontSize;
     bool mCaseEditorFontOnlyMonospaced;
@@ -110,6 +118,7 @@ private:
     qulonglong mCaseTimeout; //ms
     qulonglong mCaseMemoryLimit; //kb
     qint64 mMaxCaseInputFileSize; // mb
+    int mCaseConcurrency;
 
 protected:
     void doSave() override;
@@ -45,6 +45,7 @@ void ExecutorProblemSetWidget::doLoad()
 
     ui->cbProblemCaseValidateType->setCurrentIndex((int)(pSettings->executor().problemCaseValidateType()));
     ui->chkRedirectStderr->setChecked(pSettings->executor().redirectStderrToToolLog());
+    ui->chkRedirectOutputToFile->setChecked(pSettings->executor().redirectCaseOutputToFile());
 
     ui->cbFont->setCurrentFont(QFont(pSettings->executor().caseEditorFontName()));
     ui->spinFontSize->setValue(pSettings->executor().caseEditorFontSize());
@@ -54,6 +55,7 @@ void ExecutorProblemSetWidget::doLoad()
     ui->spinCaseTimeout->setValue(pSettings->executor().caseTimeout());
     ui->spinMemoryLimit->setValue(pSettings->executor().caseMemoryLimit());
     ui->spinMaxCaseInputFileSize->setValue(pSettings->executor().maxCaseInputFileSize());
+    ui->spinCaseConcurrency->setValue(pSettings->executor().caseConcurrency());
 }
 
 void ExecutorProblemSetWidget::doSave()
@@ -65,6 +67,7 @@ void ExecutorProblemSetWidget::doSave()
     pSettings->executor().setConvertHTMLToTextForExpected(ui->chkConvertExpectedHTML->isChecked());
     pSettings->executor().setProblemCaseValidateType((ProblemCaseValidateType)(ui->cbProblemCaseValidateType->currentIndex()));
     pSettings->executor().setRedirectStderrToToolLog(ui->chkRedirectStderr->isChecked());
+    pSettings->executor().setRedirectCaseOutputToFile(ui->chkRedirectOutputToFile->isChecked());
     pSettings->executor().setCaseEditorFontName(ui->cbFont->currentFont().family());
     pSettings->executor().setCaseEditorFontOnlyMonospaced(ui->chkOnlyMonospaced->isChecked());
     pSettings->executor().setCaseEditorFontSize(ui->spinFontSize->value());
@@ -72,6 +75,7 @@ void ExecutorProblemSetWidget::doSave()
     pSettings->executor().setCaseTimeout(ui->spinCaseTimeout->value());
     pSettings->executor().setCaseMemoryLimit(ui->spinMemoryLimit->value());
     pSettings->executor().setMaxCaseInputFileSize(ui->spinMaxCaseInputFileSize->value());
+    pSettings->executor().setCaseConcurrency(ui->spinCaseConcurrency->value());
     pSettings->executor().save();
     pMainWindow->applySettings();
 }
@@ -19,6 +19,8 @@
 #include "../settings/compilersetsettings.h"
 #include "../settings.h"
 #include "../mainwindow.h"
+#include <QDir>
+#include <qt_utils/utils.h>
 
 void resetCppParser(std::shared_ptr<CppParser> parser, int compilerSetIndex)
 {
@@ -69,6 +71,14 @@ void resetCppParser(std::shared_ptr<CppParser> parser, int compilerSetIndex)
         parser->addHardDefineByLine("#define __TIME__  1");
     }
     parser->parseHardDefines();
+    if (compilerSet && pSettings->codeCompletion().cacheSystemHeaders()) {
+        QString cacheDir = getFilePath(pSettings->dirs().config(), "parsercache");
+        if (QDir().mkpath(cacheDir)) {
+            parser->setSystemHeaderCacheFile(
+                        getFilePath(cacheDir, parser->systemHeaderCacheKey()+".cache"));
+            parser->loadSystemHeaderCache();
+        }
+    }
     pMainWindow->disconnect(parser.get(),
                             &CppParser::parseStarted,
                             pMainWindow,
@@ -300,6 +300,16 @@ void CodeCompletionPopup::addFunctionWithoutDefinitionChildren(const PStatement&
     }
 }
 
+// Filtering and choosing write the match positions and the usage count into the statements.
+// Shared statements (from the system header cache) are read by other parsers and their
+// threads, so the list gets copies of them.
+static PStatement statementForCompletion(const PStatement& statement)
+{
+    if (!statement->isReadOnly())
+        return statement;
+    return std::make_shared<Statement>(*statement);
+}
+
 void CodeCompletionPopup::addStatement(const PStatement& statement, const QString &fileName, int line)
 {
     if (mAddedStatements.contains(statement->command))
@@ -322,7 +332,7 @@ void CodeCompletionPopup::addStatement(const PStatement& statement, const QStrin
         return;
     mAddedStatements.insert(statement->command);
     if (statement->kind == StatementKind::UserCodeSnippet || !statement->command.contains("<"))
-        mFullCompletionStatementList.append(statement);
+        mFullCompletionStatementList.append(statementForCompletion(statement));
 }
 
 static bool nameComparator(PStatement statement1,PStatement statement2) {
@@ -1041,7 +1051,7 @@ void CodeCompletionPopup::getCompletionListForLabels(const QString &fileName, in
                 ) {
             foreach(const PStatement &child, scopeStatement->children) {
                 if (child->kind == StatementKind::Label) {
-                    mFullCompletionStatementList.append(child);
+                    mFullCompletionStatementList.append(statementForCompletion(child));
                 }
             }
         }
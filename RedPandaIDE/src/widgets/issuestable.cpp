@@ -101,6 +101,15 @@ void IssuesModel::addIssue(PCompileIssue issue)
     endInsertRows();
 }
 
+void IssuesModel::addIssues(const QVector<PCompileIssue> &issues)
+{
+    if (issues.isEmpty())
+        return;
+    beginInsertRows(QModelIndex(),mIssues.size(),mIssues.size()+issues.size()-1);
+    mIssues.append(issues);
+    endInsertRows();
+}
+
 void IssuesModel::clearIssues()
 {
     QSet<QString> issueFiles;
@@ -155,6 +164,11 @@ void IssuesTable::addIssue(PCompileIssue issue)
     mModel->addIssue(issue);
 }
 
+void IssuesTable::addIssues(const QVector<PCompileIssue> &issues)
+{
+    mModel->addIssues(issues);
+}
+
 PCompileIssue IssuesTable::issue(const QModelIndex &index)
 {
     if (!index.isValid())
@@ -21,12 +21,12 @@
 #include <QDebug>
 #include <QProgressDialog>
 #include <QCompleter>
-#include <QStack>
 #include <QFileDialog>
 #include <qsynedit/document.h>
 #include <qsynedit/searcher/basicsearcher.h>
 #include <qsynedit/searcher/regexsearcher.h>
 #include "../editor.h"
+#include "../filesearcher.h"
 #include "../mainwindow.h"
 #include "../editormanager.h"
 #include "../project.h"
@@ -41,12 +41,14 @@ SearchInFileDialog::SearchInFileDialog(QWidget *parent) :
     ui->setupUi(this);
     mBasicSearchEngine= std::make_shared<QSynedit::BasicSearcher>();
     mRegexSearchEngine= std::make_shared<QSynedit::RegexSearcher>();
+    mSearchThread = nullptr;
     ui->cbFind->completer()->setCaseSensitivity(Qt::CaseSensitive);
     on_rbFolder_toggled(false);
 }
 
 SearchInFileDialog::~SearchInFileDialog()
 {
+    cancelSearch();
     delete ui;
 }
 
@@ -170,85 +172,12 @@ void SearchInFileDialog::doSearch(bool replace)
         if (ui->txtFilters->text().trimmed().isEmpty()) {
             ui->txtFilters->setText("*.*");
         }
-        QDir rootDir(ui->txtFolder->text());
-        // loop through editors, add results to message control
-        QProgressDialog progressDlg(
-                    tr("Searching..."),
-                    tr("Abort"),
-                    0,
-                    1,
-                    pMainWindow);
-
-        progressDlg.setWindowModality(Qt::WindowModal);
-        QStack<QDir> dirs;
-        QSet<QString> searched;
-        QList<QFileInfo> files;
-        dirs.push(rootDir);
-        QDir::Filters filterOptions=QDir::Files | QDir::NoSymLinks;
-        if (PATH_SENSITIVITY==Qt::CaseSensitive)
-            filterOptions |= QDir::CaseSensitive;
-        while (!dirs.isEmpty()) {
-            QDir dir=dirs.back();
-            dirs.pop_back();
-            foreach(const QFileInfo& entry, dir.entryInfoList(QDir::NoSymLinks | QDir::Dirs)) {
-                if (entry.fileName()==".." || entry.fileName()==".")
-                    continue;
-                if (!searched.contains(entry.absoluteFilePath())) {
-                    dirs.push_back(QDir(entry.absoluteFilePath()));
-                    searched.insert(entry.absoluteFilePath());
-                }
-            }
-            foreach(const QFileInfo& entry, dir.entryInfoList(ui->txtFilters->text().split(";"), filterOptions)) {
-                files.append(entry);
-            }
-        }
-        progressDlg.setMaximum(files.count());
-        int i=0;
-        foreach (const QFileInfo &info, files) {
-            QString curFilename =  info.absoluteFilePath();
-            i++;
-            progressDlg.setValue(i);
-            progressDlg.setLabelText(tr("Searching...")+"<br/>"+curFilename);
-
-            if (progressDlg.wasCanceled())
-                break;
-            Editor * e = pMainWindow->editorManager()->getOpenedEditor(curFilename);
-            if (e) {
-                fileSearched++;
-                PSearchResultTreeItem parentItem = batchFindInEditor(
-                            e,
-                            e->filename(),
-                            keyword,searchOptions,useRegex);
-                int t = parentItem->results.size();
-                //findCount+=t;
-                if (t>0) {
-                    fileHitted++;
-                    results->results.append(parentItem);
-                }
-            } else if (fileExists(curFilename)) {
-                QSynedit::QSynEdit editor;
-                QByteArray realEncoding;
-                try{
-                    editor.loadFromFile(curFilename,ENCODING_AUTO_DETECT, realEncoding);
-                } catch (QSynedit::BinaryFileError e) {
-                    continue;
-                } catch (FileError e) {
-                    continue;
-                }
-                fileSearched++;
-                PSearchResultTreeItem parentItem = batchFindInEditor(
-                            &editor,
-                            curFilename,
-                            keyword,searchOptions,useRegex);
-                int t = parentItem->results.size();
-                //findCount+=t;
-                if (t>0) {
-                    fileHitted++;
-                    results->results.append(parentItem);
-                }
-            }
-        }
-        pMainWindow->searchResultModel()->notifySearchResultsUpdated();
+        FileSearchThread* thread = new FileSearchThread(keyword, searchOptions, useRegex);
+        thread->setFolder(ui->txtFolder->text(),
+                          ui->txtFilters->text().split(";"),
+                          ui->cbSearchSubFolders->isChecked());
+        thread->setOpenedFileContents(openedFileContents());
+        startSearchThread(thread, results);
     } else if (ui->rbCurrentFile->isChecked()) {
         PSearchResults results = pMainWindow->searchResultModel()->addSearchResults(
                     keyword,
@@ -281,66 +210,82 @@ void SearchInFileDialog::doSearch(bool replace)
                     SearchFileScope::wholeProject
                     );
         QByteArray projectEncoding = pMainWindow->project()->options().encoding;
-        QProgressDialog progressDlg(
-                    tr("Searching..."),
-                    tr("Abort"),
-                    0,
-                    pMainWindow->project()->unitList().count(),
-                    pMainWindow);
-
-        progressDlg.setWindowModality(Qt::WindowModal);
-        int i=0;
+        QStringList files;
+        QHash<QString,QByteArray> encodings;
         foreach (PProjectUnit unit, pMainWindow->project()->unitList()) {
-            i++;
-            progressDlg.setValue(i);
-            progressDlg.setLabelText(tr("Searching...")+"<br/>"+unit->fileName());
-
-            if (progressDlg.wasCanceled())
-                break;
-            Editor * e = pMainWindow->project()->unitEditor(unit);
-            QString curFilename =  unit->fileName();
-            if (e) {
-                fileSearched++;
-                PSearchResultTreeItem parentItem = batchFindInEditor(
-                            e,
-                            e->filename(),
-                            keyword,searchOptions,useRegex);
-                int t = parentItem->results.size();
-                //findCount+=t;
-                if (t>0) {
-                    fileHitted++;
-                    results->results.append(parentItem);
-                }
-            } else if (fileExists(curFilename)) {
-                QSynedit::QSynEdit editor;
-                QByteArray encoding=unit->encoding();
-                if (encoding==ENCODING_PROJECT)
-                    encoding = projectEncoding;
-                QByteArray realEncoding;
-                try {
-                    editor.loadFromFile(curFilename,encoding, realEncoding);
-                } catch (QSynedit::BinaryFileError e) {
-                    continue;
-                } catch (FileError e) {
-                    continue;
-                }
-                fileSearched++;
-                PSearchResultTreeItem parentItem = batchFindInEditor(
-                            &editor,
-                            curFilename,
-                            keyword,searchOptions,useRegex);
-                int t = parentItem->results.size();
-                //findCount+=t;
-                if (t>0) {
-                    fileHitted++;
-                    results->results.append(parentItem);
-                }
-            }
+            files.append(unit->fileName());
+            QByteArray encoding=unit->encoding();
+            if (encoding==ENCODING_PROJECT)
+                encoding = projectEncoding;
+            encodings.insert(unit->fileName(), encoding);
         }
-        pMainWindow->searchResultModel()->notifySearchResultsUpdated();
+        FileSearchThread* thread = new FileSearchThread(keyword, searchOptions, useRegex);
+        thread->setFiles(files, encodings);
+        thread->setOpenedFileContents(openedFileContents());
+        startSearchThread(thread, results);
     }
     pMainWindow->showSearchPanel(replace);
+}
 
+QHash<QString, QStringList> SearchInFileDialog::openedFileContents() const
+{
+    QHash<QString, QStringList> contents;
+    for (int i=0;i<pMainWindow->editorManager()->pageCount();i++) {
+        Editor * e=pMainWindow->editorManager()->operator[](i);
+        if (e!=nullptr)
+            contents.insert(e->filename(), e->content());
+    }
+    return contents;
+}
+
+void SearchInFileDialog::startSearchThread(FileSearchThread *thread, std::shared_ptr<SearchResults> results)
+{
+    cancelSearch();
+    mSearchThread = thread;
+    QProgressDialog* progressDlg = new QProgressDialog(
+                tr("Searching..."),
+                tr("Abort"),
+                0,
+                0,
+                pMainWindow);
+    progressDlg->setWindowModality(Qt::NonModal);
+    connect(progressDlg, &QProgressDialog::canceled,
+            thread, &FileSearchThread::cancel, Qt::DirectConnection);
+    connect(thread, &FileSearchThread::filesCollected,
+            progressDlg, &QProgressDialog::setMaximum);
+    connect(thread, &FileSearchThread::searchingFile,
+            progressDlg, [progressDlg](const QString& filename, int index){
+        progressDlg->setValue(index);
+        progressDlg->setLabelText(tr("Searching...")+"<br/>"+filename);
+    });
+    // results are added to the search panel while searching
+    connect(thread, &FileSearchThread::fileSearched,
+            this, [this, results](PSearchResultTreeItem fileItem){
+        results->results.append(fileItem);
+        if (!mNotifyTimer.isValid() || mNotifyTimer.elapsed()>=200) {
+            pMainWindow->searchResultModel()->notifySearchResultsUpdated();
+            mNotifyTimer.restart();
+        }
+    });
+    connect(thread, &QThread::finished,
+            this, [this, thread, progressDlg](){
+        pMainWindow->searchResultModel()->notifySearchResultsUpdated();
+        mNotifyTimer.invalidate();
+        if (mSearchThread == thread)
+            mSearchThread = nullptr;
+        progressDlg->deleteLater();
+        thread->deleteLater();
+    });
+    mNotifyTimer.invalidate();
+    thread->start();
+}
+
+void SearchInFileDialog::cancelSearch()
+{
+    if (mSearchThread) {
+        mSearchThread->cancel();
+        mSearchThread->wait();
+    }
 }
 
 int SearchInFileDialog::execute(QSynedit::QSynEdit *editor, const QString &sSearch,
@@ -18,6 +18,7 @@
 #define SEARCHINFILEDIALOG_H
 
 #include <QDialog>
+#include <QElapsedTimer>
 #include <qsynedit/qsynedit.h>
 #include "../utils.h"
 
@@ -26,8 +27,10 @@ class SearchInFileDialog;
 }
 
 struct SearchResultTreeItem;
+struct SearchResults;
 class QTabBar;
 class Editor;
+class FileSearchThread;
 class SearchInFileDialog : public QDialog
 {
     Q_OBJECT
@@ -67,11 +70,16 @@ private:
            const QString& keyword,
            QSynedit::SearchOptions searchOptions,
            bool useRegex);
+   QHash<QString, QStringList> openedFileContents() const;
+   void startSearchThread(FileSearchThread* thread, std::shared_ptr<SearchResults> results);
+   void cancelSearch();
 private:
     Ui::SearchInFileDialog *ui;
     QSynedit::PSearcher mBasicSearchEngine;
     QSynedit::PSearcher mRegexSearchEngine;
     QStringList mSearchKeys;
+    FileSearchThread* mSearchThread;
+    QElapsedTimer mNotifyTimer;
 
     // QWidget interface
 protected:
@@ -1,4 +1,7 @@
 #include <QTest>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
 #include "src/parser/cppparser.h"
 #include "test_cppparser.h"
 
@@ -29,3 +32,94 @@ void TestCppParser::test_parse_var()
     QCOMPARE(statement->kind,StatementKind::Variable);
 
 }
+
+void TestCppParser::test_statement_strings_shared()
+{
+    mParser->setOnGetFileStream([](const QString& filename, QStringList& buffer){
+        buffer=QStringList({
+                               "unsigned long long aaa=1;",
+                               "unsigned long long bbb=2;",
+                               "void foo(const char* s, int n);",
+                               "void bar(const char* s, int n);"
+                           });
+           return true;
+                                });
+    CppParser::parseFileBlocking(mParser,"text.cpp",false,"");
+    PStatement aaa = mParser->findStatement("aaa");
+    PStatement bbb = mParser->findStatement("bbb");
+    QVERIFY(aaa!=nullptr);
+    QVERIFY(bbb!=nullptr);
+    QVERIFY(!aaa->type.isEmpty());
+    QCOMPARE(aaa->type.constData(),bbb->type.constData());
+    QCOMPARE(aaa->fileName.constData(),bbb->fileName.constData());
+    PStatement foo = mParser->findStatement("foo");
+    PStatement bar = mParser->findStatement("bar");
+    QVERIFY(foo!=nullptr);
+    QVERIFY(bar!=nullptr);
+    QCOMPARE(foo->noNameArgs,bar->noNameArgs);
+    QCOMPARE(foo->noNameArgs.constData(),bar->noNameArgs.constData());
+}
+
+void TestCppParser::test_string_pool_prune_keeps_used_strings()
+{
+    StringPool pool;
+    PStatement statement = std::make_shared<Statement>();
+    statement->type = "unsigned long long";
+    statement->fileName = "text.cpp";
+    pool.internStatementStrings(*statement);
+    // held outside of the statements, like a copy in a read snapshot
+    QString unused = pool.intern("const char*");
+    PStatement copy = std::make_shared<Statement>(*statement);
+    pool.prune({statement});
+    QCOMPARE(pool.count(),2);
+    QCOMPARE(pool.intern(QString("unsigned long long")).constData(),statement->type.constData());
+    QCOMPARE(pool.intern(QString("text.cpp")).constData(),statement->fileName.constData());
+    QCOMPARE(copy->type.constData(),statement->type.constData());
+    QCOMPARE(unused,"const char*");
+}
+
+static bool writeTextFile(const QString& fileName, const QByteArray& text)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+        return false;
+    return file.write(text)==text.length();
+}
+
+void TestCppParser::test_definition_in_cached_scope_keeps_locals()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString includeDir = dir.filePath("include");
+    QVERIFY(QDir().mkpath(includeDir));
+    QVERIFY(writeTextFile(QDir(includeDir).filePath("cached.h"),
+                          "namespace cached {\n"
+                          "    void f();\n"
+                          "}\n"));
+    QString source = dir.filePath("main.cpp");
+    QVERIFY(writeTextFile(source,
+                          "#include <cached.h>\n"
+                          "void cached::f() {\n"
+                          "    int local;\n"
+                          "}\n"));
+    QString cacheFile = dir.filePath("headers.cache");
+
+    // the first parser saves the header cache
+    PCppParser parser1 = std::make_shared<CppParser>();
+    parser1->addIncludePath(includeDir);
+    parser1->setSystemHeaderCacheFile(cacheFile);
+    CppParser::parseFileBlocking(parser1,source,false,"");
+    QVERIFY(QFile::exists(cacheFile));
+
+    // the second one shares the cached namespace
+    PCppParser parser2 = std::make_shared<CppParser>();
+    parser2->addIncludePath(includeDir);
+    parser2->setSystemHeaderCacheFile(cacheFile);
+    QVERIFY(parser2->loadSystemHeaderCache());
+    CppParser::parseFileBlocking(parser2,source,false,"");
+    PStatement function = parser2->findScopeStatement(source,2);
+    QVERIFY(function!=nullptr);
+    QCOMPARE(function->command,"f");
+    QVERIFY(!function->isReadOnly());
+    QVERIFY(function->children.contains("local"));
+}
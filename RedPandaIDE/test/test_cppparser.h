@@ -13,6 +13,9 @@ public:
 private slots:
     void init_parser();
     void test_parse_var();
+    void test_statement_strings_shared();
+    void test_string_pool_prune_keeps_used_strings();
+    void test_definition_in_cached_scope_keeps_locals();
 protected:
     std::shared_ptr<CppParser> mParser;
 };
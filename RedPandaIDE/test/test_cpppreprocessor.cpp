@@ -107,6 +107,21 @@ void TestCppPreprocessor::test_macro_replace_7()
     QCOMPARE(text1,text2);
 }
 
+void TestCppPreprocessor::test_macro_replace_after_redefine()
+{
+    CppPreprocessor preprocessor;
+    preprocessor.addHardDefineByLine("#define N 1");
+    preprocessor.addHardDefineByLine("#define F(x) [x]");
+    QCOMPARE("[1] [1]",
+             preprocessor.expandMacros("F(N) F(N)"));
+    preprocessor.addHardDefineByLine("#define N 2");
+    QCOMPARE("[2]",
+             preprocessor.expandMacros("F(N)"));
+    preprocessor.addHardDefineByLine("#define F(x) {x}");
+    QCOMPARE("{2}",
+             preprocessor.expandMacros("F(N)"));
+}
+
 QStringList TestCppPreprocessor::filterIncludes(const QStringList &text)
 {
     QStringList result;
@@ -125,6 +125,7 @@ target("RedPandaIDE")
         "src/cpprefacter",
         "src/editor",
         "src/editormanager",
+        "src/filesearcher",
         "src/iconsmanager",
         "src/main",
         "src/project",
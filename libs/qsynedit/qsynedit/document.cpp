@@ -23,11 +23,20 @@
 #include <stdexcept>
 #include <QMessageBox>
 #include <cmath>
+#include <climits>
+#include <cstdint>
+#include <cstring>
 #include <optional>
 #include "qt_utils/charsetinfo.h"
 #include <QDateTime>
 #include <QDebug>
 
+// change texts longer than this (in chars) are compressed in the undo list
+#define UNDO_COMPRESS_MIN_LENGTH 16384
+#define DEFAULT_MAX_UNDO_MEMORY_USAGE (64*1024*1024)
+// the initial (saved) state can't be reached by undo anymore
+#define UNREACHABLE_CHANGE_NUMBER SIZE_MAX
+
 namespace QSynedit {
 
 Document::Document(const QFont& font, QObject *parent):
@@ -41,11 +50,6 @@ Document::Document(const QFont& font, QObject *parent):
     mNewlineType = NewlineType::Windows;
     mIndexOfLongestLine = -1;
     mUpdateCount = 0;
-    mUpdateDocumentLineWidthFunc = std::bind(&GlyphCalculator::calcLineWidth,
-        &mGlyphCalculator,
-        std::placeholders::_1,
-        std::placeholders::_2,
-        std::placeholders::_3);
     ensureHasLine();
 }
 
@@ -167,7 +171,7 @@ void Document::insertItem(int line, const QString &s)
 {
     beginUpdate();
     PDocumentLine documentLine = std::make_shared<DocumentLine>(
-                mUpdateDocumentLineWidthFunc);
+                &mGlyphCalculator);
     documentLine->setLineText(s);
     mLines.insert(line,documentLine);
     mLineSeqIndice.insert(documentLine->lineSeq(), documentLine);
@@ -179,7 +183,7 @@ void Document::insertItem(int line, const QString &s)
 void Document::addItem(const QString &s)
 {
     beginUpdate();
-    PDocumentLine line = std::make_shared<DocumentLine>(mUpdateDocumentLineWidthFunc);
+    PDocumentLine line = std::make_shared<DocumentLine>(&mGlyphCalculator);
     line->setLineText(s);
     mLines.append(line);
     mLineSeqIndice.insert(line->lineSeq(), line);
@@ -206,6 +210,29 @@ void Document::setSyntaxState(int line, const PSyntaxState& state)
     mLines[line]->setSyntaxState(state);
 }
 
+PLineTokens Document::getLineTokens(int line) const
+{
+    QMutexLocker locker(&mMutex);
+    if (line<0 || line>=mLines.count())
+        return PLineTokens();
+    return mLines[line]->tokens();
+}
+
+void Document::setLineTokens(int line, const PLineTokens &tokens)
+{
+    QMutexLocker locker(&mMutex);
+    if (line<0 || line>=mLines.count())
+        return;
+    mLines[line]->setTokens(tokens);
+}
+
+void Document::clearLineTokens()
+{
+    QMutexLocker locker(&mMutex);
+    for (const PDocumentLine& line:mLines)
+        line->setTokens(PLineTokens());
+}
+
 QString Document::getLine(int line) const
 {
     QMutexLocker locker(&mMutex);
@@ -281,6 +308,8 @@ void Document::setContents(const QStringList &text)
     beginUpdate();
     internalClear();
     if (text.count() > 0) {
+        mLines.reserve(text.count());
+        mLineSeqIndice.reserve(text.count());
         foreach (const QString& s,text) {
             addItem(s);
         }
@@ -294,6 +323,7 @@ QStringList Document::content() const
 {
     QMutexLocker locker(&mMutex);
     QStringList result;
+    result.reserve(mLines.count());
     DocumentLines list = mLines;
     foreach (const PDocumentLine& line, list) {
         result.append(line->lineText());
@@ -401,9 +431,8 @@ void Document::moveLine(int from, int to)
     Q_ASSERT(from >= 0 && from < mLines.count());
     Q_ASSERT(to >= 0 && to < mLines.count());
     beginUpdate();
-    PDocumentLine temp = mLines[from];
-    mLines.remove(from);
-    mLines.insert(to, temp);
+    // only shift lines between from and to
+    mLines.move(from, to);
     Q_ASSERT(mLineSeqIndice.count() == mLines.count());
     if (from<to) {
         if (mIndexOfLongestLine == from) {
@@ -488,65 +517,86 @@ void Document::insertLines(int index, int numLines)
     PDocumentLine line;
     mLines.insert(index,numLines,line);
     for (int i=index;i<index+numLines;i++) {
-        mLines[i] = std::make_shared<DocumentLine>(mUpdateDocumentLineWidthFunc);
+        mLines[i] = std::make_shared<DocumentLine>(&mGlyphCalculator);
         mLineSeqIndice.insert(mLines[i]->lineSeq(), mLines[i]);
     }
     Q_ASSERT(mLineSeqIndice.count() == mLines.count());
     mIndexOfLongestLine = -1;
 }
 
-bool Document::tryLoadFileByEncoding(QByteArray encodingName, QFile& file) {
+// find the line break ('\n') of the line starting at pos, or the end of the data
+static int findLineEnd(const QByteArray& data, int pos)
+{
+    const char* start = data.constData()+pos;
+    const char* lineEnd = (const char*)memchr(start, '\n', data.size()-pos);
+    if (!lineEnd)
+        return data.size();
+    return lineEnd - data.constData();
+}
+
+// length of the line without the line break
+static int lineLength(const QByteArray& data, int pos, int lineEnd)
+{
+    if (lineEnd>pos && data[lineEnd-1]=='\r')
+        return lineEnd-pos-1;
+    return lineEnd-pos;
+}
+
+// check if there are '\0' or non-ascii chars in the bytes, in one pass
+static void checkLineBytes(const char* bytes, int len, bool& hasZero, bool& allAscii)
+{
+    // no early exit, so the compiler can vectorize the loop
+    unsigned char bits = 0;
+    int zeros = 0;
+    for (int i=0;i<len;i++) {
+        unsigned char c = bytes[i];
+        bits |= c;
+        zeros += (c == 0);
+    }
+    hasZero = (zeros>0);
+    allAscii = (bits<0x80);
+}
+
+bool Document::tryLoadFileByEncoding(QByteArray encodingName, const QByteArray& data) {
     TextDecoder decoder(encodingName);
     if (!decoder.isValid())
         return false;
-    file.reset();
     internalClear();
-    while (true) {
-        if (file.atEnd()){
-            break;
-        }
-        QByteArray line = file.readLine();
-        if (line.endsWith("\r\n")) {
-            line.remove(line.length()-2,2);
-        } else if (line.endsWith("\r")) {
-            line.remove(line.length()-1,1);
-        } else if (line.endsWith("\n")){
-            line.remove(line.length()-1,1);
-        }
-        auto [ok, newLine] = decoder.decode(line);
+    int pos = 0;
+    while (pos < data.size()) {
+        int lineEnd = findLineEnd(data, pos);
+        auto [ok, newLine] = decoder.decode(
+                    QByteArray::fromRawData(data.constData()+pos, lineLength(data, pos, lineEnd)));
         if (!ok) {
             return false;
         }
         addItem(newLine);
+        pos = lineEnd+1;
     }
     return true;
 }
 
-void Document::loadUTF16BOMFile(QFile &file)
+void Document::loadUTF16BOMFile(const QByteArray& data)
 {
     TextDecoder decoder = TextDecoder::decoderForUtf16();
     if (!decoder.isValid())
         return;
-    file.reset();
     internalClear();
-    QByteArray buf = file.readAll();
-    if (buf.length()<2)
+    if (data.length()<2)
         return;
-    QString text = decoder.decodeUnchecked(buf.mid(2));
+    QString text = decoder.decodeUnchecked(data.mid(2));
     this->setText(text);
 }
 
-void Document::loadUTF32BOMFile(QFile &file)
+void Document::loadUTF32BOMFile(const QByteArray& data)
 {
     TextDecoder decoder = TextDecoder::decoderForUtf32();
     if (!decoder.isValid())
         return;
-    file.reset();
     internalClear();
-    QByteArray buf = file.readAll();
-    if (buf.length()<4)
+    if (data.length()<4)
         return;
-    QString text = decoder.decodeUnchecked(buf.mid(4));
+    QString text = decoder.decodeUnchecked(data.mid(4));
     this->setText(text);
 }
 
@@ -607,30 +657,42 @@ void Document::loadFromFile(const QString& filename, const QByteArray& encoding,
         ensureHasLine();
         endUpdate();
     });
+    // Lines are decoded right from the mapped file, without copying them out first.
+    // Read the file if it can't be mapped (empty or not a regular file).
+    qint64 fileSize = file.size();
+    uchar* mappedData = nullptr;
+    if (fileSize>0 && fileSize<=INT_MAX)
+        mappedData = file.map(0, fileSize);
+    QByteArray data;
+    if (mappedData)
+        data = QByteArray::fromRawData((const char*)mappedData, fileSize);
+    else
+        data = file.readAll();
     //test for utf8 / utf 8 bom
     if (encoding == ENCODING_AUTO_DETECT) {
-        if (file.atEnd()) {
+        if (data.isEmpty()) {
             realEncoding = ENCODING_ASCII;
             return;
         }
-        QByteArray line = file.readLine();
+        const unsigned char* bytes = (const unsigned char*)data.constData();
+        int pos = 0;
         std::optional<TextDecoder> decoder;
         bool needReread = false;
         bool allAscii = true;
         //test for BOM
-        if ((line.length()>=3) && ((unsigned char)line[0]==0xEF) && ((unsigned char)line[1]==0xBB) && ((unsigned char)line[2]==0xBF) ) {
+        if ((data.length()>=3) && (bytes[0]==0xEF) && (bytes[1]==0xBB) && (bytes[2]==0xBF) ) {
             realEncoding = ENCODING_UTF8_BOM;
-            line = line.mid(3);
+            pos = 3;
             decoder = TextDecoder::decoderForUtf8();
-        } else if ((line.length()>=4) && ((unsigned char)line[0]==0xFF) && ((unsigned char)line[1]==0xFE)
-                   && ((unsigned char)line[2]==0x00)
-                   && ((unsigned char)line[3]==0x00)) {
+        } else if ((data.length()>=4) && (bytes[0]==0xFF) && (bytes[1]==0xFE)
+                   && (bytes[2]==0x00)
+                   && (bytes[3]==0x00)) {
             realEncoding = ENCODING_UTF32_BOM;
-            loadUTF32BOMFile(file);
+            loadUTF32BOMFile(data);
             return;
-        } else if ((line.length()>=2) && ((unsigned char)line[0]==0xFF) && ((unsigned char)line[1]==0xFE)) {
+        } else if ((data.length()>=2) && (bytes[0]==0xFF) && (bytes[1]==0xFE)) {
             realEncoding = ENCODING_UTF16_BOM;
-            loadUTF16BOMFile(file);
+            loadUTF16BOMFile(data);
             return;
         } else {
             realEncoding = ENCODING_UTF8;
@@ -638,42 +700,38 @@ void Document::loadFromFile(const QString& filename, const QByteArray& encoding,
         }
         if (!decoder.has_value())
             throw FileError(tr("Can't load codec '%1'!").arg(QString(realEncoding)));
-        if (line.endsWith("\r\n")) {
-            mNewlineType = NewlineType::Windows;
-        } else if (line.endsWith("\n")) {
-            mNewlineType = NewlineType::Unix;
-        } else if (line.endsWith("\r")) {
+        int firstLineEnd = findLineEnd(data, pos);
+        if (firstLineEnd < data.size()) {
+            if (lineLength(data, pos, firstLineEnd) < firstLineEnd - pos)
+                mNewlineType = NewlineType::Windows;
+            else
+                mNewlineType = NewlineType::Unix;
+        } else if (data.endsWith('\r')) {
             mNewlineType = NewlineType::MacOld;
         }
 
         internalClear();
-        while (true) {
-            if (line.endsWith("\r\n")) {
-                line.remove(line.length()-2,2);
-            } else if (line.endsWith("\r")) {
-                line.remove(line.length()-1,1);
-            } else if (line.endsWith("\n")){
-                line.remove(line.length()-1,1);
-            }
-            if (isBinaryContent(line))
+        while (pos < data.size()) {
+            int lineEnd = findLineEnd(data, pos);
+            int len = lineLength(data, pos, lineEnd);
+            const char* lineBytes = data.constData()+pos;
+            bool hasZero;
+            bool lineAllAscii;
+            checkLineBytes(lineBytes, len, hasZero, lineAllAscii);
+            if (hasZero)
                 throw BinaryFileError(tr("'%1' is a binaray File!").arg(filename));
-            if (allAscii) {
-                allAscii = isTextAllAscii(line);
-            }
-            if (allAscii) {
-                addItem(QString::fromLatin1(line));
+            if (lineAllAscii) {
+                addItem(QString::fromLatin1(lineBytes, len));
             } else {
-                auto [ok, newLine] = decoder->decode(line);
+                allAscii = false;
+                auto [ok, newLine] = decoder->decode(QByteArray::fromRawData(lineBytes, len));
                 if (!ok) {
                     needReread = true;
                     break;
                 }
                 addItem(newLine);
             }
-            if (file.atEnd()){
-                break;
-            }
-            line = file.readLine();
+            pos = lineEnd+1;
         }
         if (!needReread) {
             if (allAscii)
@@ -681,7 +739,7 @@ void Document::loadFromFile(const QString& filename, const QByteArray& encoding,
             return;
         }
         realEncoding = pCharsetInfoManager->getDefaultSystemEncoding();
-        if (tryLoadFileByEncoding(realEncoding,file)) {
+        if (tryLoadFileByEncoding(realEncoding,data)) {
             return;
         }
         QList<PCharsetInfo> charsets = pCharsetInfoManager->findCharsetByLocale(pCharsetInfoManager->localeName());
@@ -695,7 +753,7 @@ void Document::loadFromFile(const QString& filename, const QByteArray& encoding,
             foreach (const QByteArray& encodingName,encodingSet) {
                 if (encodingName == ENCODING_UTF8)
                     continue;
-                if (tryLoadFileByEncoding(encodingName,file)) {
+                if (tryLoadFileByEncoding(encodingName,data)) {
                     //qDebug()<<encodingName;
                     realEncoding = encodingName;
                     return;
@@ -709,8 +767,6 @@ void Document::loadFromFile(const QString& filename, const QByteArray& encoding,
     if (realEncoding == ENCODING_SYSTEM_DEFAULT) {
         realEncoding = pCharsetInfoManager->getDefaultSystemEncoding();
     }
-    file.reset();
-    QByteArray data = file.readAll();
     QString text;
     QTextStream textStream(&text);
     if (realEncoding == ENCODING_UTF8_BOM) {
@@ -812,8 +868,7 @@ QString Document::glyphAt(int line, int charPos) const
     // Crash Prevention
     if (line<0 || line>=count())
         return 0;
-    QList<int> glyphStartCharList = mLines[line]->glyphStartCharList();
-    int glyphIdx = charToGlyphIndex(mLines[line]->lineText(), glyphStartCharList, charPos);
+    int glyphIdx = mLines[line]->charToGlyphIndex(charPos);
     return mLines[line]->glyph(glyphIdx);
 }
 
@@ -824,8 +879,7 @@ int Document::charToGlyphStartChar(int line, int charPos) const
     // Crash Prevention
     if (line<0 || line>=count())
         return 0;
-    QList<int> glyphStartCharList = mLines[line]->glyphStartCharList();
-    int glyphIdx = charToGlyphIndex(mLines[line]->lineText(), glyphStartCharList, charPos);
+    int glyphIdx = mLines[line]->charToGlyphIndex(charPos);
     return mLines[line]->glyphStartChar(glyphIdx);
 }
 
@@ -837,9 +891,26 @@ int Document::charToGlyphStartChar(int line, int charPos) const
 //     return mLines[line]->glyphStartColumn(glyphIdx);
 // }
 
+bool isOneCharPerGlyph(const QString &text)
+{
+    // all chars are below U+0200 (checked without branches), so there are
+    // no combining chars, joiners, variation selectors or surrogates
+    ushort bits = 0;
+    for (const QChar& ch:text) {
+        bits |= ch.unicode();
+    }
+    return bits < 0x200;
+}
+
 QList<int> calcGlyphStartCharList(const QString &text)
 {
     QList<int> glyphStartCharList;
+    if (isOneCharPerGlyph(text)) {
+        glyphStartCharList.reserve(text.length());
+        for (int i=0;i<text.length();i++)
+            glyphStartCharList.append(i);
+        return glyphStartCharList;
+    }
     //parse mGlyphs
     int i=0;
     bool consecutive = false;
@@ -971,8 +1042,7 @@ int Document::charToGlyphIndex(int line, int charIdx) const
     // Crash Prevention
     if (line<0 || line>=count())
         return 0;
-    QList<int> glyphStartCharList = mLines[line]->glyphStartCharList();
-    return charToGlyphIndex(mLines[line]->lineText(), glyphStartCharList, charIdx);
+    return mLines[line]->charToGlyphIndex(charIdx);
 }
 
 int Document::charToGlyphIndex(const QString& str, const QList<int> &glyphStartCharList, int charIdx) const
@@ -1019,8 +1089,7 @@ int Document::charToGlyphStartPosition(int line, int charPos) const
     QMutexLocker locker(&mMutex);
     if (line<0 || line>=count())
         return 0;
-    QList<int> glyphStartCharList = mLines[line]->glyphStartCharList();
-    int glyphIdx = charToGlyphIndex(mLines[line]->lineText(), glyphStartCharList, charPos);
+    int glyphIdx = mLines[line]->charToGlyphIndex(charPos);
     return mLines[line]->glyphStartPosition(glyphIdx);
 }
 
@@ -1169,7 +1238,7 @@ void Document::setLineWidth(int line, int newWidth, const QList<int> &glyphStart
         mIndexOfLongestLine = line;
         updateMaxLineWidthChanged();
     }
-    Q_ASSERT(mLines[line]->mGlyphStartPositionList.length() == mLines[line]->mGlyphStartCharList.length());
+    Q_ASSERT(mLines[line]->mGlyphStartPositionList.length() == mLines[line]->glyphsCount());
 }
 
 void Document::updateMaxLineWidthChanged()
@@ -1263,24 +1332,64 @@ void Document::invalidateAllNonTempLineWidth()
 //Reserve 0
 size_t DocumentLine::seqCounter = 1;
 
-DocumentLine::DocumentLine(DocumentLine::UpdateWidthFunc updateWidthFunc):
+DocumentLine::DocumentLine(const GlyphCalculator* glyphCalculator):
+    mGlyphsState{GlyphsState::Calculated},
     mSyntaxState{},
     mWidth{-1},
     mIsTempWidth{true},
-    mUpdateWidthFunc{updateWidthFunc},
+    mGlyphCalculator{glyphCalculator},
     mLineSeq{seqCounter++}
 {
 
 }
 
+int DocumentLine::glyphsCount() const
+{
+    ensureGlyphStartCharList();
+    if (mGlyphsState == GlyphsState::OneCharPerGlyph)
+        return mLineText.length();
+    return mGlyphStartCharList.length();
+}
+
+QList<int> DocumentLine::glyphStartCharList() const
+{
+    ensureGlyphStartCharList();
+    if (mGlyphsState == GlyphsState::OneCharPerGlyph)
+        return calcGlyphStartCharList(mLineText);
+    return mGlyphStartCharList;
+}
+
+int DocumentLine::charToGlyphIndex(int charPos) const
+{
+    ensureGlyphStartCharList();
+    if (mGlyphsState == GlyphsState::OneCharPerGlyph)
+        return std::max(0, std::min(charPos, (int)mLineText.length()));
+    return searchForSegmentIdx(mGlyphStartCharList, mLineText.length(), charPos);
+}
+
+void DocumentLine::ensureGlyphStartCharList() const
+{
+    if (mGlyphsState != GlyphsState::NotCalculated)
+        return;
+    if (isOneCharPerGlyph(mLineText)) {
+        mGlyphsState = GlyphsState::OneCharPerGlyph;
+    } else {
+        mGlyphStartCharList = calcGlyphStartCharList(mLineText);
+        mGlyphsState = GlyphsState::Calculated;
+    }
+}
+
 int DocumentLine::glyphLength(int i) const
 {
+    ensureGlyphStartCharList();
+    if (mGlyphsState == GlyphsState::OneCharPerGlyph)
+        return (i>=0 && i<mLineText.length()) ? 1 : 0;
     return calcSegmentInterval(mGlyphStartCharList, mLineText.length(), i);
 }
 
 QString DocumentLine::glyph(int i) const
 {
-   if (i<0 || i>=mGlyphStartCharList.length())
+   if (i<0 || i>=glyphsCount())
        return QString();
    return mLineText.mid(glyphStartChar(i),glyphLength(i));
 }
@@ -1313,14 +1422,17 @@ int DocumentLine::width()
 void DocumentLine::setLineText(const QString &newLineText)
 {
     mLineText = newLineText;
-    mGlyphStartCharList = calcGlyphStartCharList(newLineText);
+    // glyphs are calculated when the line is painted or measured
+    mGlyphStartCharList.clear();
+    mGlyphsState = GlyphsState::NotCalculated;
+    mTokens.reset();
     invalidateWidth();
 }
 
 void DocumentLine::updateWidth()
 {
-    Q_ASSERT(mUpdateWidthFunc!=nullptr);
-    mGlyphStartPositionList = mUpdateWidthFunc(mLineText, mGlyphStartCharList, mWidth);
+    Q_ASSERT(mGlyphCalculator!=nullptr);
+    mGlyphStartPositionList = mGlyphCalculator->calcLineWidth(mLineText, glyphStartCharList(), mWidth);
 //    qDebug()<<"Update Width"<<mLineText<<mWidth<<mGlyphPositionList;
 }
 
@@ -1335,6 +1447,9 @@ int DocumentLine::glyphStartChar(int i) const
 {
    if (i<0)
        return 0;
+   ensureGlyphStartCharList();
+   if (mGlyphsState == GlyphsState::OneCharPerGlyph)
+       return std::min(i, (int)mLineText.length());
    if (i>=mGlyphStartCharList.length())
        return mLineText.length();
    return mGlyphStartCharList[i];
@@ -1346,11 +1461,15 @@ UndoList::UndoList():QObject()
     mInsideRedo = false;
 
     mBlockChangeNumber=0;
+    mMergedChangeNumber=0;
     mBlockLock=0;
     mFullUndoImposible=false;
     mLastPoppedItemChangeNumber=0;
     mInitialChangeNumber = 0;
     mLastRestoredItemChangeNumber=0;
+    mMaxUndoActions = 0;
+    mMaxMemoryUsage = DEFAULT_MAX_UNDO_MEMORY_USAGE;
+    mMemoryUsage = 0;
 }
 
 PUndoItem UndoList::addChange(ChangeReason reason, const CharPos &startPos,
@@ -1362,7 +1481,7 @@ PUndoItem UndoList::addChange(ChangeReason reason, const CharPos &startPos,
                 reason,
                 selMode,startPos,endPos,changeText,
                 mBlockChangeNumber);
-    mItems.append(newItem);
+    appendItem(newItem);
 
     if (reason!=ChangeReason::GroupBreak && !inBlock()) {
         emit addedUndo();
@@ -1383,7 +1502,7 @@ void UndoList::restoreChange(ChangeReason reason, const CharPos &startPos,
 void UndoList::restoreChange(PUndoItem item)
 {
     size_t changeNumber = item->changeNumber();
-    mItems.append(item);
+    appendItem(item);
     if (changeNumber>mNextChangeNumber)
         mNextChangeNumber=changeNumber;
     if (changeNumber!=mLastRestoredItemChangeNumber) {
@@ -1392,6 +1511,34 @@ void UndoList::restoreChange(PUndoItem item)
     mLastRestoredItemChangeNumber=changeNumber;
 }
 
+bool UndoList::mergeInput(const CharPos &start, const CharPos &end)
+{
+    Q_ASSERT(inBlock());
+    if (mItems.isEmpty() || start.line!=end.line)
+        return false;
+    PUndoItem lastItem = mItems.last();
+    if (lastItem->changeReason()!=ChangeReason::Input
+            || lastItem->changeEndPos()!=start
+            || lastItem->changeStartPos().line!=start.line)
+        return false;
+    // the modified state is decided by the change number of the last change
+    if (lastItem->changeNumber()==mInitialChangeNumber)
+        return false;
+    // can't merge if the last input replaced some chars (in overwrite mode)
+    QStringList lastText = lastItem->changeText();
+    if (lastText.length()!=1 || !lastText[0].isEmpty())
+        return false;
+    mItems.last() = std::make_shared<UndoItem>(
+                ChangeReason::Input,
+                lastItem->changeSelMode(),
+                lastItem->changeStartPos(),
+                end,
+                lastText,
+                lastItem->changeNumber());
+    mMergedChangeNumber = lastItem->changeNumber();
+    return true;
+}
+
 void UndoList::addGroupBreak()
 {
     if (!canUndo())
@@ -1423,6 +1570,8 @@ void UndoList::beginBlock(const CharPos &caret, const CharPos &selBegin, const C
 void UndoList::clear()
 {
     mItems.clear();
+    mMemoryUsage = 0;
+    mMergedChangeNumber = 0;
     mFullUndoImposible = false;
     mInitialChangeNumber=0;
     mLastPoppedItemChangeNumber=0;
@@ -1439,7 +1588,9 @@ void UndoList::endBlock(const CharPos &caret, const CharPos &selBegin, const Cha
         mBlockLock--;
         if (mBlockLock == 0)  {
             size_t iBlockID = mBlockChangeNumber;
+            size_t mergedID = mMergedChangeNumber;
             mBlockChangeNumber = 0;
+            mMergedChangeNumber = 0;
             if (mItems.count() > 0 && peekItem()->changeNumber() == iBlockID) {
                 mCaretInfoAfterChange.insert(
                             iBlockID,
@@ -1449,7 +1600,22 @@ void UndoList::endBlock(const CharPos &caret, const CharPos &selBegin, const Cha
                                 selEnd,
                                 selMode
                                 ));
+                ensureMaxEntries();
                 emit addedUndo();
+            } else {
+                // no change is added by the block
+                mCaretInfoBeforeChange.remove(iBlockID);
+                if (mergedID!=0 && mItems.count() > 0 && peekItem()->changeNumber() == mergedID) {
+                    mCaretInfoAfterChange.insert(
+                                mergedID,
+                                std::make_shared<CaretAndSelectionInfo>(
+                                    caret,
+                                    selBegin,
+                                    selEnd,
+                                    selMode
+                                    ));
+                    emit addedUndo();
+                }
             }
         }
     }
@@ -1491,6 +1657,49 @@ unsigned int UndoList::getNextChangeNumber()
     return mNextChangeNumber++;
 }
 
+void UndoList::appendItem(const PUndoItem &item)
+{
+    mItems.append(item);
+    mMemoryUsage += item->memoryUsage();
+}
+
+void UndoList::ensureMaxEntries()
+{
+    bool overCount = mMaxUndoActions>0 && mItems.count()>mMaxUndoActions;
+    bool overMemory = mMaxMemoryUsage>0 && mMemoryUsage>mMaxMemoryUsage;
+    if (!overCount && !overMemory)
+        return;
+    // remove the oldest changes, but always keep the last one
+    size_t lastChangeNumber = mItems.last()->changeNumber();
+    int removeCount = 0;
+    size_t memoryUsage = mMemoryUsage;
+    bool initialStateRemoved = (mInitialChangeNumber==0);
+    while (removeCount<mItems.count()) {
+        if ((mMaxUndoActions<=0 || mItems.count()-removeCount<=mMaxUndoActions)
+                && (mMaxMemoryUsage==0 || memoryUsage<=mMaxMemoryUsage))
+            break;
+        size_t changeNumber = mItems[removeCount]->changeNumber();
+        if (changeNumber==lastChangeNumber)
+            break;
+        // a change must be undone as a whole
+        while (removeCount<mItems.count() && mItems[removeCount]->changeNumber()==changeNumber) {
+            memoryUsage -= mItems[removeCount]->memoryUsage();
+            removeCount++;
+        }
+        if (changeNumber==mInitialChangeNumber)
+            initialStateRemoved = true;
+        mCaretInfoBeforeChange.remove(changeNumber);
+        mCaretInfoAfterChange.remove(changeNumber);
+    }
+    if (removeCount>0) {
+        mItems.remove(0, removeCount);
+        mMemoryUsage = memoryUsage;
+        mFullUndoImposible = true;
+        if (initialStateRemoved)
+            mInitialChangeNumber = UNREACHABLE_CHANGE_NUMBER;
+    }
+}
+
 ChangeReason UndoList::lastChangeReason()
 {
     if (mItems.count() == 0)
@@ -1521,6 +1730,7 @@ PUndoItem UndoList::popItem()
 //        qDebug()<<"popped"<<item->changeNumber()<<item->changeText()<<(int)item->changeReason()<<mLastPoppedItemChangeNumber;
         mLastPoppedItemChangeNumber =  item->changeNumber();
         mItems.removeLast();
+        mMemoryUsage -= item->memoryUsage();
         return item;
     }
 }
@@ -1535,6 +1745,39 @@ int UndoList::itemCount()
     return mItems.count();
 }
 
+int UndoList::maxUndoActions() const
+{
+    return mMaxUndoActions;
+}
+
+void UndoList::setMaxUndoActions(int maxUndoActions)
+{
+    if (maxUndoActions!=mMaxUndoActions) {
+        mMaxUndoActions = maxUndoActions;
+        if (!mItems.isEmpty() && !inBlock())
+            ensureMaxEntries();
+    }
+}
+
+size_t UndoList::maxMemoryUsage() const
+{
+    return mMaxMemoryUsage;
+}
+
+void UndoList::setMaxMemoryUsage(size_t maxMemoryUsage)
+{
+    if (maxMemoryUsage!=mMaxMemoryUsage) {
+        mMaxMemoryUsage = maxMemoryUsage;
+        if (!mItems.isEmpty() && !inBlock())
+            ensureMaxEntries();
+    }
+}
+
+size_t UndoList::memoryUsage() const
+{
+    return mMemoryUsage;
+}
+
 bool UndoList::initialState()
 {
     if (itemCount() == 0) {
@@ -1584,7 +1827,11 @@ CharPos UndoItem::changeEndPos() const
 
 QStringList UndoItem::changeText() const
 {
-    return mChangeText;
+    if (mCompressedChangeText.isEmpty())
+        return mChangeText;
+    QByteArray data = qUncompress(mCompressedChangeText);
+    QString text = QString((const QChar*)data.constData(), data.size() / (int)sizeof(QChar));
+    return text.split('\n');
 }
 
 size_t UndoItem::changeNumber() const
@@ -1592,6 +1839,11 @@ size_t UndoItem::changeNumber() const
     return mChangeNumber;
 }
 
+size_t UndoItem::memoryUsage() const
+{
+    return mMemoryUsage;
+}
+
 UndoItem::UndoItem(ChangeReason reason, SelectionMode selMode,
                                  CharPos startPos, CharPos endPos,
                                  const QStringList& text, int number)
@@ -1600,12 +1852,22 @@ UndoItem::UndoItem(ChangeReason reason, SelectionMode selMode,
     mChangeSelMode = selMode;
     mChangeStartPos = startPos;
     mChangeEndPos = endPos;
-    mChangeText = text;
     mChangeNumber = number;
-    int length=0;
+    size_t length=0;
     foreach (const QString& s, text) {
         length+=s.length();
     }
+    mMemoryUsage = sizeof(UndoItem);
+    if (length >= UNDO_COMPRESS_MIN_LENGTH) {
+        // lines don't contain '\n', so it's safe to join them with it
+        QString joined = text.join('\n');
+        mCompressedChangeText = qCompress(
+                    QByteArray::fromRawData((const char*)joined.constData(), joined.length() * (int)sizeof(QChar)));
+        mMemoryUsage += mCompressedChangeText.size();
+    } else {
+        mChangeText = text;
+        mMemoryUsage += length * sizeof(QChar) + text.count() * sizeof(QString);
+    }
 }
 
 ChangeReason UndoItem::changeReason() const
@@ -21,10 +21,12 @@
 #include <QFontMetrics>
 #include <QMutex>
 #include <QVector>
+#include <QHash>
 #include <memory>
 #include <QFile>
 #include "miscprocs.h"
 #include "types.h"
+#include "syntaxer/syntaxer.h"
 #include "qt_utils/utils.h"
 
 namespace QSynedit {
@@ -35,9 +37,32 @@ int searchForSegmentIdx(const QList<int> &segList, int maxVal, int value);
 int calcSegmentInterval(const QList<int> &segList, int maxVal, int idx);
 int segmentIntervalStart(const QList<int> &segList, int maxVal, int idx);
 QList<int> calcGlyphStartCharList(const QString &text);
+bool isOneCharPerGlyph(const QString &text);
 void expandGlyphStartCharList(const QString& strAdded, int oldStrLen, QList<int> &glyphStartCharList);
 
 class Document;
+class GlyphCalculator;
+
+/**
+ * @brief A token of a line, as scanned by the syntaxer
+ */
+struct LineToken {
+    int start; // start index in the line text
+    int length;
+    PTokenAttribute attribute;
+    int bracketLevel; // nesting level used to color brackets, -1 if it's not a bracket
+};
+
+/**
+ * @brief Tokens of a line, cached to paint the line without scanning it again
+ */
+struct LineTokens {
+    PSyntaxState startState; // state the line is scanned from, nullptr for the first line
+    QVector<LineToken> tokens;
+    int endBraceLevel; // brace level after the line is scanned
+};
+
+using PLineTokens = std::shared_ptr<const LineTokens>;
 
 using SearchConfirmAroundProc = std::function<bool ()>;
 /**
@@ -56,9 +81,7 @@ using SearchConfirmAroundProc = std::function<bool ()>;
  */
 class DocumentLine {
 public:
-    using UpdateWidthFunc = std::function<QList<int>(const QString&, const QList<int> &, int &)>;
-
-    explicit DocumentLine(UpdateWidthFunc updateWidthFunc);
+    explicit DocumentLine(const GlyphCalculator* glyphCalculator);
     DocumentLine(const DocumentLine&)=delete;
     DocumentLine& operator=(const DocumentLine&)=delete;
 
@@ -78,13 +101,20 @@ private:
      *
      * @return the glyphs count
      */
-    int glyphsCount() const { return mGlyphStartCharList.length(); }
+    int glyphsCount() const;
 
     /**
      * @brief get list of start index of the glyphs in the line text
      * @return start indice of the glyph.
      */
-    const QList<int>& glyphStartCharList() const { return mGlyphStartCharList; }
+    QList<int> glyphStartCharList() const;
+
+    /**
+     * @brief get index of the glyph containing the specified char
+     * @param charPos index of the char in the line text
+     * @return index of the glyph
+     */
+    int charToGlyphIndex(int charPos) const;
 
     /**
      * @brief get list of start position of the glyphs in the line text
@@ -146,10 +176,22 @@ private:
      */
     void setSyntaxState(const PSyntaxState &newSyntaxState) { mSyntaxState = newSyntaxState; }
 
+    /**
+     * @brief get the cached tokens of the line, cleared when the line text is changed
+     */
+    PLineTokens tokens() const { return mTokens; }
+    void setTokens(const PLineTokens &newTokens) { mTokens = newTokens; }
+
     void setLineText(const QString &newLineText);
     void updateWidth();
     void invalidateWidth() { mWidth = -1; mGlyphStartPositionList.clear(); mIsTempWidth = true;}
+    void ensureGlyphStartCharList() const;
 private:
+    enum class GlyphsState {
+        NotCalculated,
+        OneCharPerGlyph, // each char is a glyph, mGlyphStartCharList is not used
+        Calculated
+    };
     QString mLineText; /* the unicode code points of the text */
     /**
      * @brief Start positions of glyphs in mLineText
@@ -157,8 +199,11 @@ private:
      * A glyph may be defined by more than one code points.
      * Each lement of mGlyphStartCharList (position) is the start index
      *  of the code points in the mLineText.
+     *
+     * It's calculated when first used, and left empty if each char is a glyph.
      */
-    QList<int> mGlyphStartCharList;
+    mutable QList<int> mGlyphStartCharList;
+    mutable GlyphsState mGlyphsState;
     /**
      * @brief start columns of the glyphs
      *
@@ -175,6 +220,7 @@ private:
      * Which is also used in auto-indent calculating and other functions.
      */
     PSyntaxState mSyntaxState;
+    PLineTokens mTokens;
     /**
      * @brief total width (pixel) of the line text
      *
@@ -183,7 +229,8 @@ private:
      */
     int mWidth;
     bool mIsTempWidth;
-    UpdateWidthFunc mUpdateWidthFunc;
+    // owned by the document, shared by all its lines
+    const GlyphCalculator* mGlyphCalculator;
     size_t mLineSeq;
     static size_t seqCounter;
     friend class Document;
@@ -261,7 +308,7 @@ public:
 
     int stringWidth(const QString &str, int left, const QFontMetrics &fontMetrics);
 
-    QList<int> calcLineWidth(const QString& lineText, const QList<int> &glyphStartCharList, int &width) {
+    QList<int> calcLineWidth(const QString& lineText, const QList<int> &glyphStartCharList, int &width) const {
         return calcGlyphPositionList(lineText,glyphStartCharList,0,width);
     }
     QList<int> calcGlyphPositionList(const QString& lineText, int &width) const;
@@ -410,6 +457,33 @@ public:
      */
     void setSyntaxState(int line, const PSyntaxState& state);
 
+    /**
+     * @brief get the cached tokens of the specified line.
+     *
+     * It's thread safe.
+     *
+     * @param line line index (starts frome 0)
+     * @return the tokens, or nullptr if the line is not scanned since its text changed
+     */
+    PLineTokens getLineTokens(int line) const;
+
+    /**
+     * @brief cache the tokens of the specified line.
+     *
+     * It's thread safe.
+     *
+     * @param line line index (starts frome 0)
+     * @param tokens the tokens
+     */
+    void setLineTokens(int line, const PLineTokens& tokens);
+
+    /**
+     * @brief clear cached tokens of all lines (when the syntaxer is changed)
+     *
+     * It's thread safe.
+     */
+    void clearLineTokens();
+
     /**
      * @brief get line text of the specified line.
      *
@@ -643,16 +717,14 @@ private:
     QList<int> getGlyphStartCharList(int line, const QString &lineText);
     QList<int> getGlyphStartCharList(int line);
     QList<int> getGlyphStartPositionList(int line);
-    bool tryLoadFileByEncoding(QByteArray encodingName, QFile& file);
-    void loadUTF16BOMFile(QFile& file);
-    void loadUTF32BOMFile(QFile& file);
+    bool tryLoadFileByEncoding(QByteArray encodingName, const QByteArray& data);
+    void loadUTF16BOMFile(const QByteArray& data);
+    void loadUTF32BOMFile(const QByteArray& data);
     void saveUTF16File(QFile& file, TextEncoder &encoder) const;
     void saveUTF32File(QFile& file, TextEncoder &encoder) const;
 private:
     DocumentLines mLines;
-    QMap<size_t,PDocumentLine> mLineSeqIndice;
-
-    DocumentLine::UpdateWidthFunc mUpdateDocumentLineWidthFunc;
+    QHash<size_t,PDocumentLine> mLineSeqIndice;
 
     NewlineType mNewlineType;
     bool mAppendNewLineAtEOF;
@@ -705,7 +777,10 @@ private:
     CharPos mChangeStartPos;
     CharPos mChangeEndPos;
     QStringList mChangeText;
+    // big change texts are kept compressed, see changeText()
+    QByteArray mCompressedChangeText;
     size_t mChangeNumber;
+    size_t mMemoryUsage;
 public:
     UndoItem(ChangeReason reason,
         SelectionMode selMode,
@@ -720,6 +795,7 @@ public:
     CharPos changeEndPos() const;
     QStringList changeText() const;
     size_t changeNumber() const;
+    size_t memoryUsage() const;
 };
 
 using PUndoItem = std::shared_ptr<UndoItem>;
@@ -737,6 +813,12 @@ public:
 
     void restoreChange(PUndoItem item);
 
+    /**
+     * @brief Extends the last input change with the text typed right after it
+     * @return false if the text can't be merged, and should be added as a new change
+     */
+    bool mergeInput(const CharPos& start, const CharPos& end);
+
     void addGroupBreak();
     void beginBlock(const CharPos &caret, const CharPos &selBegin, const CharPos &selEnd, SelectionMode selMode);
     void endBlock(const CharPos &caret, const CharPos &selBegin, const CharPos &selEnd, SelectionMode selMode);
@@ -758,8 +840,13 @@ public:
     bool canUndo();
     int itemCount();
 
+    // max count of changes kept, 0 means unlimited
     int maxUndoActions() const;
     void setMaxUndoActions(int maxUndoActions);
+    // max bytes used by the changes kept, 0 means unlimited
+    size_t maxMemoryUsage() const;
+    void setMaxMemoryUsage(size_t maxMemoryUsage);
+    size_t memoryUsage() const;
     bool initialState();
     void setInitialState();
 
@@ -773,9 +860,13 @@ signals:
 protected:
     bool inBlock();
     unsigned int getNextChangeNumber();
+    void appendItem(const PUndoItem& item);
+    void ensureMaxEntries();
 
 protected:
     size_t mBlockChangeNumber;
+    // the change the current block is merged into by mergeInput()
+    size_t mMergedChangeNumber;
     int mBlockLock;
     size_t mLastPoppedItemChangeNumber;
     size_t mLastRestoredItemChangeNumber;
@@ -784,6 +875,9 @@ protected:
     size_t mNextChangeNumber;
     size_t mInitialChangeNumber;
     bool mInsideRedo;
+    int mMaxUndoActions;
+    size_t mMaxMemoryUsage;
+    size_t mMemoryUsage;
     QMap<size_t, PCaretAndSelectionInfo> mCaretInfoBeforeChange;
     QMap<size_t, PCaretAndSelectionInfo> mCaretInfoAfterChange;
 };
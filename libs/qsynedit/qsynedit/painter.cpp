@@ -696,6 +696,58 @@ void QSynEditPainter::paintHighlightToken(const QString& lineText,
     }
 }
 
+PLineTokens QSynEditPainter::getLineTokens(int line, const QString &lineText, bool lineTextChanged)
+{
+    PSyntaxState startState;
+    if (line>0)
+        startState = mEdit->mDocument->getSyntaxState(line-1);
+    if (!lineTextChanged) {
+        PLineTokens lineTokens = mEdit->mDocument->getLineTokens(line);
+        if (lineTokens) {
+            if (lineTokens->startState == startState
+                    || (lineTokens->startState && startState
+                        && lineTokens->startState->equals(startState)))
+                return lineTokens;
+        }
+    }
+    std::shared_ptr<LineTokens> lineTokens = std::make_shared<LineTokens>();
+    lineTokens->startState = startState;
+    mEdit->startParseLine(mEdit->mSyntaxer.get(), line, lineText);
+    while (!mEdit->mSyntaxer->eol()) {
+        QString token = mEdit->mSyntaxer->getToken();
+        if (!token.isEmpty()) {
+            LineToken lineToken;
+            lineToken.start = mEdit->mSyntaxer->getTokenPos();
+            lineToken.length = token.length();
+            lineToken.attribute = mEdit->mSyntaxer->getTokenAttribute();
+            lineToken.bracketLevel = -1;
+            if (token == "["
+                    || token == "("
+                    || token == "{"
+                    ) {
+                PSyntaxState rangeState = mEdit->mSyntaxer->getState();
+                lineToken.bracketLevel = rangeState->bracketLevel
+                        +rangeState->braceLevel
+                        +rangeState->parenthesisLevel;
+            } else if (token == "]"
+                       || token == ")"
+                       || token == "}"
+                       ){
+                PSyntaxState rangeState = mEdit->mSyntaxer->getState();
+                lineToken.bracketLevel = rangeState->bracketLevel
+                        +rangeState->braceLevel
+                        +rangeState->parenthesisLevel+1;
+            }
+            lineTokens->tokens.append(lineToken);
+        }
+        mEdit->mSyntaxer->next();
+    }
+    lineTokens->endBraceLevel = mEdit->mSyntaxer->getState()->braceLevel;
+    if (!lineTextChanged)
+        mEdit->mDocument->setLineTokens(line, lineTokens);
+    return lineTokens;
+}
+
 // Store the token chars with the attributes in the TokenAccu
 // record. This will paint any chars already stored if there is
 // a (visible) change in the attributes.
@@ -742,7 +794,7 @@ void QSynEditPainter::addHighlightToken(
 //        Background = colEditorBG();
 //    }
 
-    mEdit->onPreparePaintHighlightToken(line,mEdit->mSyntaxer->getTokenPos(),
+    mEdit->onPreparePaintHighlightToken(line,tokenStartChar,
         token,attri,style,foreground,background);
 
     if (!background.isValid() ) {
@@ -1074,10 +1126,9 @@ void QSynEditPainter::paintLines()
             glyphStartPositionsList = mEdit->mDocument->getGlyphStartPositionList(vLine);
             mCurrentLineWidth = mEdit->mDocument->lineWidth(vLine);
         }
-        // Initialize highlighter with line text and range info. It is
-        // necessary because we probably did not scan to the end of the last
-        // line - the internal highlighter range might be wrong.
-        mEdit->startParseLine(mEdit->mSyntaxer.get(), vLine, sLine);
+        // Tokens are cached in the document, so unchanged lines are not scanned
+        // by the syntaxer again on each repaint.
+        PLineTokens lineTokens = getLineTokens(vLine, sLine, lineTextChanged);
         // Try to concatenate as many tokens as possible to minimize the count
         // of ExtTextOut calls necessary. This depends on the selection state
         // or the line having special colors. For spaces the foreground color
@@ -1085,42 +1136,21 @@ void QSynEditPainter::paintLines()
         mTokenAccu.width = 0;
         tokenLeft = 0;
         // Test first whether anything of this token is visible.
-        while (!mEdit->mSyntaxer->eol()) {
-            sToken = mEdit->mSyntaxer->getToken();
-            if (sToken.isEmpty())  {
-                mEdit->mSyntaxer->next();
-                continue;
-            }
-            int tokenStartChar = mEdit->mSyntaxer->getTokenPos();
-            int tokenEndChar = tokenStartChar + sToken.length();
+        foreach (const LineToken& token, lineTokens->tokens) {
+            sToken = sLine.mid(token.start, token.length);
+            int tokenStartChar = token.start;
+            int tokenEndChar = tokenStartChar + token.length;
 
             // It's at least partially visible. Get the token attributes now.
-            attr = mEdit->mSyntaxer->getTokenAttribute();
+            attr = token.attribute;
 
             //rainbow parenthesis
-            if (sToken == "["
-                    || sToken == "("
-                    || sToken == "{"
-                    ) {
-                PSyntaxState rangeState = mEdit->mSyntaxer->getState();
-                getBraceColorAttr(rangeState->bracketLevel
-                                  +rangeState->braceLevel
-                                  +rangeState->parenthesisLevel
-                                  ,attr);
-            } else if (sToken == "]"
-                       || sToken == ")"
-                       || sToken == "}"
-                       ){
-                PSyntaxState rangeState = mEdit->mSyntaxer->getState();
-                getBraceColorAttr(rangeState->bracketLevel
-                                  +rangeState->braceLevel
-                                  +rangeState->parenthesisLevel+1,
-                                  attr);
-            }
+            if (token.bracketLevel>=0)
+                getBraceColorAttr(token.bracketLevel, attr);
             //input method
 //            if (mIsCurrentLine && mEdit->mInputPreeditString.length()>0) {
-//                int startPos = mEdit->mSyntaxer->getTokenPos();
-//                int endPos = mEdit->mSyntaxer->getTokenPos() + sToken.length();
+//                int startPos = tokenStartChar;
+//                int endPos = tokenStartChar + sToken.length();
 //                if (!(endPos < mEdit->mCaretX
 //                        || startPos >= mEdit->mCaretX+mEdit->mInputPreeditString.length())) {
 //                    if (!preeditAttr) {
@@ -1132,7 +1162,7 @@ void QSynEditPainter::paintLines()
 //            }
             bool showGlyph=false;
             if (attr && attr->tokenType() == TokenType::Space) {
-                int pos = mEdit->mSyntaxer->getTokenPos();
+                int pos = tokenStartChar;
                 if (pos==0) {
                     showGlyph = mEdit->mOptions.testFlag(EditorOption::ShowLeadingSpaces);
                 } else if (pos+sToken.length()==sLine.length()) {
@@ -1157,8 +1187,6 @@ void QSynEditPainter::paintLines()
             //So we just quit if already out of the right edge of the editor
             if (lineWidthValid && (tokenLeft>mRight))
                     break;
-            // Let the highlighter scan the next token.
-            mEdit->mSyntaxer->next();
         }
         if (!lineWidthValid)
             mEdit->mDocument->setLineWidth(vLine, tokenLeft, glyphStartPositionsList);
@@ -1170,7 +1198,7 @@ void QSynEditPainter::paintLines()
             if ((foldRange) && foldRange->collapsed) {
                 addOnStr = mEdit->mSyntaxer->foldString(sLine);
                 attr = mEdit->mSyntaxer->symbolAttribute();
-                getBraceColorAttr(mEdit->mSyntaxer->getState()->braceLevel,attr);
+                getBraceColorAttr(lineTokens->endBraceLevel,attr);
             } else {
                 // Draw LineBreak glyph.
                 if (mEdit->mOptions.testFlag(EditorOption::ShowLineBreaks)) {
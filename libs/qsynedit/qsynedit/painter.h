@@ -41,6 +41,8 @@ class Syntaxer;
 using PSyntaxer = std::shared_ptr<Syntaxer>;
 class TokenAttribute;
 using PTokenAttribute = std::shared_ptr<TokenAttribute>;
+struct LineTokens;
+using PLineTokens = std::shared_ptr<const LineTokens>;
 class QSynEdit;
 class QSynEditPainter
 {
@@ -106,6 +108,7 @@ private:
     void paintFoldAttributes();
     void getRainbowColorAttr(int level, PTokenAttribute &attr);
     void getBraceColorAttr(int level, PTokenAttribute &attr);
+    PLineTokens getLineTokens(int line, const QString& lineText, bool lineTextChanged);
     void paintLines();
 
 private:
@@ -25,6 +25,7 @@
 #include <QPaintEvent>
 #include <QPainter>
 #include <QTimerEvent>
+#include <QSet>
 #include "syntaxer/syntaxer.h"
 #include "syntaxer/cpp.h"
 #include "syntaxer/textfile.h"
@@ -44,6 +45,9 @@
 
 #define UPDATE_HORIZONTAL_SCROLLBAR_EVENT ((QEvent::Type)(QEvent::User+1))
 #define UPDATE_VERTICAL_SCROLLBAR_EVENT ((QEvent::Type)(QEvent::User+2))
+// lines out of the window are scanned in time slices (in ms), for documents with more lines than this
+#define ASYNC_REPARSE_MIN_LINES 5000
+#define ASYNC_REPARSE_TIME_SLICE 10
 
 namespace QSynedit {
 QSynEdit::QSynEdit(QWidget *parent) : QAbstractScrollArea(parent),
@@ -135,11 +139,19 @@ QSynEdit::QSynEdit(QWidget *parent) : QAbstractScrollArea(parent),
     //mScrollTimer->setInterval(100);
     connect(mScrollTimer, &QTimer::timeout,this, &QSynEdit::onScrollTimeout);
 
+    mPendingReparseLine = -1;
+    mPendingReparseToEnd = false;
+    mReparseTimer = new QTimer(this);
+    mReparseTimer->setSingleShot(true);
+    mReparseTimer->setInterval(0);
+    connect(mReparseTimer, &QTimer::timeout,this, &QSynEdit::onReparseTimeout);
+
     qreal dpr=devicePixelRatioF();
     mContentImage = std::make_shared<QImage>(clientWidth()*dpr,clientHeight()*dpr,QImage::Format_ARGB32);
     mContentImage->setDevicePixelRatio(dpr);
 
     mUseCodeFolding = true;
+    mCodeBlocksOutdated = true;
     m_blinkTimerId = 0;
     m_blinkStatus = 0;
 
@@ -383,6 +395,7 @@ void QSynEdit::doTrimTrailingSpaces()
 {
     if (mReadOnly || mDocument->empty())
         return;
+    ensureLinesReparsed(mDocument->count()-1);
     beginEditing();
     auto action=finally([this](){
         endEditing();
@@ -467,6 +480,7 @@ CharPos QSynEdit::getMatchingBracket(const CharPos &pos)
                 }
             } else {
                 // search until end of line
+                ensureLinesReparsed(pos.line);
                 if (pos.line == 0) {
                     syntaxer->resetState();
                 } else {
@@ -1356,6 +1370,7 @@ bool QSynEdit::shouldInsertAfterCurrentLine(int line, const QString &newLineText
     }
     if (newLineText2.trimmed().isEmpty())
         return true;
+    ensureLinesReparsed(line);
     PSyntaxState oldState = mDocument->getSyntaxState(line);
     PSyntaxState newState = calcSyntaxStateAtLine(line, newLineText);
     if (newState->blockStarted == 0 && newState->blockEnded==0)
@@ -1369,6 +1384,7 @@ bool QSynEdit::shouldDeleteNextLine(int line, const QString &currentLineText, co
     Q_ASSERT(line+1<mDocument->count());
     if (nextLineText.trimmed().isEmpty())
         return true;
+    ensureLinesReparsed(line);
     PSyntaxState prevLineState = mDocument->getSyntaxState(line);
     if (prevLineState->blockStarted == 0 && prevLineState->blockEnded==0)
         return false;
@@ -2651,12 +2667,19 @@ void QSynEdit::internalInputStr(const QString& inputStr)
         newS = s.left(mCaretX)+inputStr+s.mid(mCaretX);
     }
     properSetLine(mCaretY,newS,true);
-    addChangeToUndo(ChangeReason::Input,
-            CharPos{mCaretX, mCaretY},
-            CharPos{mCaretX+(int)inputStr.length(), mCaretY},
-            QStringList(replaceStr),
-            SelectionMode::Normal
-            );
+    CharPos inputEnd{mCaretX+(int)inputStr.length(), mCaretY};
+    // chars typed in the same undo group are kept in one change
+    if (mUndoing || !replaceStr.isEmpty()
+            || !mOptions.testFlag(EditorOption::GroupUndo)
+            || !mOptions.testFlag(EditorOption::MergeInputUndo)
+            || !mUndoList->mergeInput(caretXY(), inputEnd)) {
+        addChangeToUndo(ChangeReason::Input,
+                caretXY(),
+                inputEnd,
+                QStringList(replaceStr),
+                SelectionMode::Normal
+                );
+    }
     setCaretX(mCaretX+inputStr.length());
     endEditing();
 }
@@ -2716,7 +2739,9 @@ void QSynEdit::doInputStr(const QString& s)
                     if (undoItem->changeEndPos().line == mCaretY
                         && undoItem->changeEndPos().ch == mCaretX
                         && undoItem->changeStartPos().line == mCaretY
-                        && undoItem->changeStartPos().ch == mCaretX-1) {
+                        && (undoItem->changeStartPos().ch == mCaretX-1
+                            || (mOptions.testFlag(EditorOption::MergeInputUndo)
+                                && undoItem->changeStartPos().ch < mCaretX))) {
                         QString s = mDocument->getLine(mCaretY);
                         int i=mCaretX-1;
                         if (i>=0 && i<s.length())
@@ -3302,22 +3327,40 @@ int QSynEdit::reparseLines(int startLine, int endLine, bool toDocumentEnd)
         return startLine;
     }
 
+    // the scan starts from the state of the previous line, which must be valid
+    ensureLinesReparsed(startLine-1);
     if (startLine == 0) {
         mSyntaxer->resetState();
     } else {
         mSyntaxer->setState(mDocument->getSyntaxState(startLine-1));
     }
     int line = startLine;
+    bool pendingAfterStart = (mPendingReparseLine>=startLine);
+    int lastVisibleLine = rowToLine(yposToRow(clientHeight()));
     do {
+        // lines from here are already waiting to be scanned
+        if (pendingAfterStart && line >= endLine && line >= mPendingReparseLine)
+            break;
         mSyntaxer->setLine(line, mDocument->getLine(line), mDocument->getLineSeq(line));
         mSyntaxer->nextToEol();
         state = mSyntaxer->getState();
-        if (line >= endLine && state->equals(mDocument->getSyntaxState(line)) ) {
+        PSyntaxState oldState = mDocument->getSyntaxState(line);
+        if (line >= endLine && state->equals(oldState) ) {
             break;
         }
+        checkCodeBlocksOutdated(oldState, state);
         mDocument->setSyntaxState(line,state);
         line++;
+        // don't freeze the editor when a change affects lines to the end of a huge document
+        if (line >= endLine && line > lastVisibleLine && line < maxLine
+                && mDocument->count() >= ASYNC_REPARSE_MIN_LINES) {
+            scheduleReparse(line, false);
+            break;
+        }
     } while (line < maxLine);
+    // pending lines before line have been scanned, the rest are still waiting
+    if (pendingAfterStart && mPendingReparseLine<line)
+        mPendingReparseLine = line;
     invalidateLines(startLine, line);
 #ifdef QT_DEBUG
 //    qDebug()<<"parse endLine"<<endLine<<"real end"<<line;
@@ -3335,21 +3378,146 @@ int QSynEdit::reparseLines(int startLine, int endLine, bool toDocumentEnd)
     return line;
 }
 
+void QSynEdit::invalidateTokens()
+{
+    mDocument->clearLineTokens();
+    invalidate();
+}
+
 void QSynEdit::reparseDocument()
 {
+    mDocument->clearLineTokens();
+    mCodeBlocksOutdated = true;
+    mPendingReparseLine = -1;
+    mPendingReparseToEnd = false;
+    mReparseTimer->stop();
     mSyntaxer->resetState();
-    for (int i =0;i<mDocument->count();i++) {
+    int count = mDocument->count();
+    if (count >= ASYNC_REPARSE_MIN_LINES) {
+        // scan lines in the window now, and the rest in time slices
+        PSyntaxState initState = mSyntaxer->getState();
+        int lastLine = std::min(rowToLine(yposToRow(clientHeight())), count-1);
+        for (int i=0;i<=lastLine;i++) {
+            mSyntaxer->setLine(i, mDocument->getLine(i), mDocument->getLineSeq(i));
+            mSyntaxer->nextToEol();
+            mDocument->setSyntaxState(i, mSyntaxer->getState());
+        }
+        // lines not scanned yet must have a valid state
+        for (int i=lastLine+1;i<count;i++) {
+            if (!mDocument->getSyntaxState(i))
+                mDocument->setSyntaxState(i, initState);
+        }
+#ifdef QSYNEDIT_TEST
+        emit linesReparesd(0, lastLine+1);
+#endif
+        invalidateLines(0, count);
+        scheduleReparse(lastLine+1, true);
+        return;
+    }
+    for (int i =0;i<count;i++) {
         mSyntaxer->setLine(i, mDocument->getLine(i), mDocument->getLineSeq(i));
         mSyntaxer->nextToEol();
         mDocument->setSyntaxState(i, mSyntaxer->getState());
     }
 #ifdef QSYNEDIT_TEST
-    emit linesReparesd(0, mDocument->count());
+    emit linesReparesd(0, count);
 #endif
-    invalidateLines(0,mDocument->count());
+    invalidateLines(0,count);
     rescanCodeBlocks();
 }
 
+void QSynEdit::scheduleReparse(int line, bool toDocumentEnd)
+{
+    if (mPendingReparseLine<0 || mPendingReparseLine>=mDocument->count()) {
+        mPendingReparseLine = line;
+        mPendingReparseToEnd = toDocumentEnd;
+    } else {
+        // two ranges are waiting, the merged one can't stop at unchanged lines
+        mPendingReparseToEnd = toDocumentEnd || mPendingReparseToEnd || (line != mPendingReparseLine);
+        mPendingReparseLine = std::min(line, mPendingReparseLine);
+    }
+    mReparseTimer->start();
+}
+
+void QSynEdit::ensureLinesReparsed(int lastLine) const
+{
+    if (mPendingReparseLine<0 || mPendingReparseLine>lastLine)
+        return;
+    // only the cached syntax states are changed, the contents are not
+    const_cast<QSynEdit*>(this)->reparsePendingLines(lastLine, 0);
+}
+
+int QSynEdit::reparsePendingLines(int lastLine, int msecs)
+{
+    int count = mDocument->count();
+    int line = std::min(mPendingReparseLine, count);
+    if (line>=count) {
+        mPendingReparseLine = count;
+        return count;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    if (line == 0) {
+        mSyntaxer->resetState();
+    } else {
+        mSyntaxer->setState(mDocument->getSyntaxState(line-1));
+    }
+#ifdef QSYNEDIT_TEST
+    int startLine = line;
+#endif
+    bool finished = true;
+    while (line < count) {
+        mSyntaxer->setLine(line, mDocument->getLine(line), mDocument->getLineSeq(line));
+        mSyntaxer->nextToEol();
+        PSyntaxState state = mSyntaxer->getState();
+        PSyntaxState oldState = mDocument->getSyntaxState(line);
+        if (!mPendingReparseToEnd && state->equals(oldState))
+            break;
+        checkCodeBlocksOutdated(oldState, state);
+        mDocument->setSyntaxState(line, state);
+        line++;
+        if (line > lastLine && timer.elapsed() >= msecs) {
+            finished = false;
+            break;
+        }
+    }
+#ifdef QSYNEDIT_TEST
+    emit linesReparesd(startLine, line-startLine);
+#endif
+    if (line >= count)
+        finished = true;
+    // folds are rescanned by the timer, when all lines are scanned
+    mPendingReparseLine = finished ? count : line;
+    return line;
+}
+
+void QSynEdit::adjustPendingReparseOnLinesInserted(int line, int count)
+{
+    if (mPendingReparseLine>=0 && line<mPendingReparseLine)
+        mPendingReparseLine+=count;
+}
+
+void QSynEdit::adjustPendingReparseOnLinesDeleted(int line, int count)
+{
+    if (mPendingReparseLine>=0 && line<mPendingReparseLine)
+        mPendingReparseLine = std::max(line, mPendingReparseLine-count);
+}
+
+void QSynEdit::onReparseTimeout()
+{
+    if (mPendingReparseLine<0)
+        return;
+    int startLine = mPendingReparseLine;
+    int line = reparsePendingLines(-1, ASYNC_REPARSE_TIME_SLICE);
+    invalidateLines(startLine, line);
+    if (mPendingReparseLine >= mDocument->count()) {
+        mPendingReparseLine = -1;
+        mPendingReparseToEnd = false;
+        rescanCodeBlocks();
+    } else
+        mReparseTimer->start();
+}
+
 void QSynEdit::uncollapse(const PCodeBlock &foldRange)
 {
     beginInternalChanges();
@@ -3538,7 +3706,7 @@ void QSynEdit::processFoldsOnLineMoved(int from, int to)
                 block->toLine = to;
             } else if (from < block->toLine && block->toLine <= to)
                 block->toLine -= 1;
-        } else if (to > from) {
+        } else if (from > to) {
             if (block->fromLine == from) {
                 block->fromLine = to;
             } else if (to <= block->fromLine && block->fromLine < from)
@@ -3564,25 +3732,32 @@ void QSynEdit::rescanCodeBlocks()
 {
     if (!useCodeFolding())
         return;
+    // states of some lines are not valid yet, it will be called again when they are scanned
+    if (mPendingReparseLine>=0)
+        return;
+    // fold ranges are kept up to date by processCodeBlocksOnLinesInserted() and so on,
+    // if no blocks are started or ended in the changed lines
+    if (!mCodeBlocksOutdated)
+        return;
+    mCodeBlocksOutdated = false;
 
     beginInternalChanges();
     // Did we leave any collapsed folds and are we viewing a code file?
     if (mCodeBlocks.count() > 0) {
-        QMap<QString,PCodeBlock> rangeIndexes;
+        QSet<QPair<int,int>> collapsedRanges;
         foreach(const PCodeBlock& block, mCodeBlocks) {
             if (block->collapsed)
-                rangeIndexes.insert(QString("%1-%2").arg(block->fromLine).arg(block->toLine),block);
+                collapsedRanges.insert(QPair<int,int>(block->fromLine,block->toLine));
         }
 
         // Add folds to a separate list
         internalScanCodeBlocks();
 
         // Combine new with old folds, preserve parent order
-        foreach(const PCodeBlock &tempBlock, mCodeBlocks) {
-            PCodeBlock b2=rangeIndexes.value(QString("%1-%2").arg(tempBlock->fromLine).arg(tempBlock->toLine),
-                                  PCodeBlock());
-            if (b2) {
-                tempBlock->collapsed=true;
+        if (!collapsedRanges.isEmpty()) {
+            foreach(const PCodeBlock &tempBlock, mCodeBlocks) {
+                if (collapsedRanges.contains(QPair<int,int>(tempBlock->fromLine,tempBlock->toLine)))
+                    tempBlock->collapsed=true;
             }
         }
     } else {
@@ -3596,6 +3771,19 @@ void QSynEdit::rescanCodeBlocks()
     endInternalChanges();
 }
 
+void QSynEdit::checkCodeBlocksOutdated(const PSyntaxState &oldState, const PSyntaxState &newState)
+{
+    if (mCodeBlocksOutdated)
+        return;
+    int oldBlockStarted = oldState ? oldState->blockStarted : 0;
+    int oldBlockEnded = oldState ? oldState->blockEnded : 0;
+    int newBlockStarted = newState ? newState->blockStarted : 0;
+    int newBlockEnded = newState ? newState->blockEnded : 0;
+    if (oldBlockStarted != newBlockStarted
+            || oldBlockEnded != newBlockEnded)
+        mCodeBlocksOutdated = true;
+}
+
 void QSynEdit::internalScanCodeBlocks()
 {
     if (!useCodeFolding())
@@ -4863,6 +5051,7 @@ void QSynEdit::setUseCodeFolding(bool value)
 {
     if (mUseCodeFolding!=value) {
         mUseCodeFolding = value;
+        mCodeBlocksOutdated = true;
     }
 }
 
@@ -4898,6 +5087,7 @@ size_t QSynEdit::lineSeq(int line) const
 
 PSyntaxState QSynEdit::lineSyntaxState(int line) const
 {
+    ensureLinesReparsed(line);
     return mDocument->getSyntaxState(line);
 }
 
@@ -4922,6 +5112,7 @@ void QSynEdit::setSyntaxer(const PSyntaxer &syntaxer)
     Q_ASSERT(syntaxer!=nullptr);
     PSyntaxer oldSyntaxer = mSyntaxer;
     mSyntaxer = syntaxer;
+    mDocument->clearLineTokens();
     if (oldSyntaxer ->language() != syntaxer->language()) {
         recalcCharExtent();
         mDocument->beginUpdate();
@@ -4945,6 +5136,7 @@ bool QSynEdit::isSpaceChar(const QChar &ch) const
 void QSynEdit::startParseLine(Syntaxer *syntaxer, int lineIndex) const
 {
     Q_ASSERT(validLine(lineIndex));
+    ensureLinesReparsed(lineIndex-1);
     if (lineIndex == 0) {
         syntaxer->resetState();
     } else {
@@ -4956,6 +5148,7 @@ void QSynEdit::startParseLine(Syntaxer *syntaxer, int lineIndex) const
 void QSynEdit::startParseLine(Syntaxer *syntaxer, int lineIndex, const QString lineText) const
 {
     Q_ASSERT(validLine(lineIndex));
+    ensureLinesReparsed(lineIndex-1);
     if (lineIndex == 0) {
         syntaxer->resetState();
     } else {
@@ -5143,6 +5336,7 @@ void QSynEdit::moveCaretToLineEnd(bool isSelection, bool ensureCaretVisible)
 void QSynEdit::doGotoBlockStart(bool isSelection)
 {
     //todo: handle block other than {}
+    ensureLinesReparsed(mCaretY);
     if (document()->braceLevel(mCaretY)==0) {
         doGotoEditorStart(isSelection);
     } else if (document()->blockStarted(mCaretY)==0){
@@ -5165,6 +5359,7 @@ void QSynEdit::doGotoBlockStart(bool isSelection)
 void QSynEdit::doGotoBlockEnd(bool isSelection)
 {
     //todo: handle block other than {}
+    ensureLinesReparsed(lineCount()-1);
     if (document()->blockLevel(mCaretY)==0) {
         doGotoEditorEnd(isSelection);
     } else if (document()->blockEnded(mCaretY)==0){
@@ -5355,7 +5550,7 @@ int QSynEdit::searchReplace(const QString &sSearch, const QString &sReplace,
                 i = 0;
             // Operate on all results in this line.
             QSet<int> tokenBorders;
-            if (nInLine>0) {
+            if (nInLine>0 && sOptions.testFlag(ssoWholeWord)) {
                 tokenBorders = getTokenBorders(posCurrent.line);
             }
             while (nInLine > 0) {
@@ -5492,6 +5687,7 @@ void QSynEdit::properSetLine(int line, const QString &sLineText, bool parseToEnd
 void QSynEdit::properInsertLine(int line, const QString &sLineText, bool parseToEnd)
 {
     mDocument->insertLine(line, sLineText);
+    adjustPendingReparseOnLinesInserted(line, 1);
     processCodeBlocksOnLinesInserted(line,1);
     if (parseToEnd)
         onLinesInserted(line, 1);
@@ -5507,7 +5703,11 @@ void QSynEdit::properDeleteLines(int line, int count, bool parseToEnd)
 {
     if (count<=0)
         return;
+    for (int i=line;i<line+count && i<mDocument->count() && !mCodeBlocksOutdated;i++) {
+        checkCodeBlocksOutdated(mDocument->getSyntaxState(i), PSyntaxState());
+    }
     mDocument->deleteLines(line, count);
+    adjustPendingReparseOnLinesDeleted(line, count);
     processFoldsOnLinesDeleted(line, count);
     if (parseToEnd)
         onLinesDeleted(line,count);
@@ -5523,6 +5723,7 @@ void QSynEdit::properInsertLines(int line, int count, bool parseToEnd)
     if (count<=0)
         return;
     mDocument->insertLines(line, count);
+    adjustPendingReparseOnLinesInserted(line, count);
     processCodeBlocksOnLinesInserted(line, count);
     if (parseToEnd)
         onLinesInserted(line,count);
@@ -5538,6 +5739,7 @@ void QSynEdit::properMoveLine(int from, int to, bool parseToEnd)
 {
     if (from==to)
         return;
+    checkCodeBlocksOutdated(mDocument->getSyntaxState(from), PSyntaxState());
     mDocument->moveLine(from, to);
     processFoldsOnLineMoved(from,to);
     int minLine = std::min(from,to);
@@ -6197,6 +6399,9 @@ void QSynEdit::paintEvent(QPaintEvent *event)
 
         //qDebug()<<"Paint:"<<nL1<<nL2<<nC1<<nC2;
 
+        // lines to be painted must be scanned before
+        ensureLinesReparsed(rowToLine(nL2));
+
         QPainter cachePainter(mContentImage.get());
         cachePainter.setFont(font());
         QSynEditPainter textPainter(this, &cachePainter,
@@ -78,6 +78,7 @@ enum class EditorOption {
     ShowInnerSpaces =       0x00800000,
     ShowLineBreaks =        0x01000000,
     ForceMonospace =        0x02000000,
+    MergeInputUndo =        0x04000000, //Keep chars typed in the same undo group in one undo change (needs GroupUndo)
 };
 
 Q_DECLARE_FLAGS(EditorOptions, EditorOption)
@@ -424,6 +425,8 @@ public:
 
     QStringList getContent(CharPos startPos, CharPos endPos, SelectionMode mode) const;
     void reparseDocument();
+    // drop tokens cached for painting, when settings of the syntaxer affecting tokens are changed
+    void invalidateTokens();
 
     QString lineBreak() const;
 
@@ -576,6 +579,13 @@ private:
     void recalcCharExtent();
     void updateModifiedStatusForUndoRedo();
     int reparseLines(int startLine, int endLine, bool toDocumentEnd);
+    // let lines from the given line be scanned later, in time slices
+    void scheduleReparse(int line, bool toDocumentEnd);
+    // scan the pending lines until the given line, before its state is used
+    void ensureLinesReparsed(int lastLine) const;
+    int reparsePendingLines(int lastLine, int msecs);
+    void adjustPendingReparseOnLinesInserted(int line, int count);
+    void adjustPendingReparseOnLinesDeleted(int line, int count);
     //void reparseLine(int line);
     void uncollapse(const PCodeBlock &foldRange);
     void collapse(const PCodeBlock &foldRange);
@@ -583,6 +593,8 @@ private:
     void processFoldsOnLinesDeleted(int line, int count);
     void processFoldsOnLineMoved(int from, int to);
     void rescanCodeBlocks(); // rescan for folds
+    // fold ranges must be rescanned if the blocks started/ended in a line are changed
+    void checkCodeBlocksOutdated(const PSyntaxState& oldState, const PSyntaxState& newState);
     void internalScanCodeBlocks();
     PCodeBlock foldStartAtLine(int Line) const;
     //QString substringByColumns(const QString& s, int startColumn, int& colLen);
@@ -711,6 +723,7 @@ private slots:
     void onLinesChanging();
     //void onRedoAdded();
     void onScrollTimeout();
+    void onReparseTimeout();
     void onDraggingScrollTimeout();
     void onUndoAdded();
     void onSizeOrFontChanged();
@@ -779,6 +792,10 @@ private:
     int mLastKey;
     Qt::KeyboardModifiers mLastKeyModifiers;
     QTimer*  mScrollTimer;
+    QTimer*  mReparseTimer;
+    int mPendingReparseLine; // first line waiting to be scanned, -1 if none
+    bool mPendingReparseToEnd; // don't stop at lines whose states are not changed
+    bool mCodeBlocksOutdated;
 
     PSynEdit  fChainedEditor;
 
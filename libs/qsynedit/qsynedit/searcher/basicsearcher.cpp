@@ -15,10 +15,31 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "basicsearcher.h"
+#include <cstring>
 
 namespace QSynedit {
 
-BasicSearcher::BasicSearcher(QObject *parent):Searcher(parent)
+static inline QChar foldCase(const QChar& ch)
+{
+    ushort c = ch.unicode();
+    if (c < 128) {
+        if (c>='A' && c<='Z')
+            return QChar(c - 'A' + 'a');
+        return ch;
+    }
+    return ch.toCaseFolded();
+}
+
+// No other chars are case folded to ascii chars which are not letters,
+// so we can locate them by an exact (and vectorized) QString::indexOf(QChar)
+static inline bool isCaseless(const QChar& ch)
+{
+    ushort c = ch.unicode();
+    return c < 128 && !(c>='A' && c<='Z') && !(c>='a' && c<='z');
+}
+
+BasicSearcher::BasicSearcher(QObject *parent):Searcher(parent),
+    mAnchor{0}
 {
 
 }
@@ -27,7 +48,7 @@ int BasicSearcher::length(int aIndex)
 {
     if (aIndex<0 || aIndex >= mResults.length())
         return 0;
-    return pattern().length();
+    return mPattern.length();
 }
 
 int BasicSearcher::result(int aIndex)
@@ -45,21 +66,38 @@ int BasicSearcher::resultCount()
 int BasicSearcher::findAll(const QString &text)
 {
     mResults.clear();
-    if (pattern().isEmpty())
+    int patternLen = mPattern.length();
+    if (patternLen==0)
         return 0;
-    int start=0;
-    int next=-1;
-    while (true) {
-        if (options().testFlag(ssoMatchCase)) {
-            next = text.indexOf(pattern(),start,Qt::CaseSensitive);
-        } else {
-            next = text.indexOf(pattern(),start,Qt::CaseInsensitive);
+    int lastStart = text.length() - patternLen;
+    if (mAnchor<0) {
+        QChar first = mFoldedPattern[0];
+        const QChar* data = text.constData();
+        int i=0;
+        while (i<=lastStart) {
+            if (foldCase(data[i]) == first && matchesAt(text,i)) {
+                mResults.append(i);
+                i += patternLen;
+            } else
+                i++;
         }
-        if (next<0) {
-            break;
+    } else {
+        // find the anchor char first, then verify the whole pattern around it
+        QChar anchorChar = mPattern[mAnchor];
+        int pos = mAnchor;
+        while (true) {
+            pos = text.indexOf(anchorChar, pos);
+            if (pos<0)
+                break;
+            int start = pos - mAnchor;
+            if (start > lastStart)
+                break;
+            if (matchesAt(text,start)) {
+                mResults.append(start);
+                pos = start + patternLen + mAnchor;
+            } else
+                pos++;
         }
-        start = next + pattern().length();
-        mResults.append(next);
     }
     return mResults.size();
 }
@@ -69,4 +107,46 @@ QString BasicSearcher::replace(const QString &, const QString &aReplacement)
     return aReplacement;
 }
 
+void BasicSearcher::setPattern(const QString &value)
+{
+    Searcher::setPattern(value);
+    mPattern = value;
+    updatePatternInfo();
+}
+
+void BasicSearcher::setOptions(const SearchOptions &options)
+{
+    Searcher::setOptions(options);
+    updatePatternInfo();
+}
+
+void BasicSearcher::updatePatternInfo()
+{
+    mFoldedPattern.clear();
+    mAnchor = 0;
+    if (options().testFlag(ssoMatchCase))
+        return;
+    mAnchor = -1;
+    mFoldedPattern.resize(mPattern.length());
+    for (int i=0;i<mPattern.length();i++) {
+        mFoldedPattern[i] = foldCase(mPattern[i]);
+        if (mAnchor<0 && isCaseless(mPattern[i]))
+            mAnchor = i;
+    }
+}
+
+bool BasicSearcher::matchesAt(const QString &text, int pos) const
+{
+    const QChar* data = text.constData() + pos;
+    int len = mPattern.length();
+    if (mFoldedPattern.isEmpty())
+        return memcmp(data, mPattern.constData(), len * sizeof(QChar)) == 0;
+    const QChar* folded = mFoldedPattern.constData();
+    for (int i=0;i<len;i++) {
+        if (foldCase(data[i]) != folded[i])
+            return false;
+    }
+    return true;
+}
+
 }
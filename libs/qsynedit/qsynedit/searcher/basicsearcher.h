@@ -33,8 +33,19 @@ public:
     int resultCount() override;
     int findAll(const QString &text) override;
     QString replace(const QString &aOccurrence, const QString &aReplacement) override;
+    void setPattern(const QString &value) override;
+    void setOptions(const SearchOptions &options) override;
+private:
+    void updatePatternInfo();
+    bool matchesAt(const QString &text, int pos) const;
 private:
     QList<int> mResults;
+    QString mPattern;
+    // case folded pattern, for case insensitive search
+    QString mFoldedPattern;
+    // index of the char used to locate candidates with QString::indexOf(QChar)
+    // -1 if all chars of the pattern have cases (and we are searching case insensitively)
+    int mAnchor;
 };
 }
 
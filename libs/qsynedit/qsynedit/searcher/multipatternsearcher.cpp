@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "multipatternsearcher.h"
+
+#include <QQueue>
+#include <algorithm>
+
+namespace QSynedit {
+
+MultiPatternSearcher::MultiPatternSearcher(QObject *parent):Searcher(parent)
+{
+
+}
+
+void MultiPatternSearcher::setPatterns(const QStringList &patterns)
+{
+    Searcher::setPattern(patterns.join('\n'));
+    mPatterns = patterns;
+    buildAutomaton();
+}
+
+int MultiPatternSearcher::length(int aIndex)
+{
+    if (aIndex<0 || aIndex >= mResults.length())
+        return 0;
+    return mLengths[aIndex];
+}
+
+int MultiPatternSearcher::result(int aIndex)
+{
+    if (aIndex<0 || aIndex >= mResults.length())
+        return -1;
+    return mResults[aIndex];
+}
+
+int MultiPatternSearcher::resultCount()
+{
+    return mResults.count();
+}
+
+int MultiPatternSearcher::findAll(const QString &text)
+{
+    mResults.clear();
+    mLengths.clear();
+    if (mNodes.count()<=1)
+        return 0;
+    // all matches, as (start, length)
+    QVector<QPair<int,int>> matches;
+    int state = 0;
+    const QChar* data = text.constData();
+    for (int i=0;i<text.length();i++) {
+        ushort ch = normalize(data[i]);
+        while (true) {
+            auto it = mNodes[state].next.constFind(ch);
+            if (it!=mNodes[state].next.constEnd()) {
+                state = it.value();
+                break;
+            }
+            if (state==0)
+                break;
+            state = mNodes[state].fail;
+        }
+        int output = mNodes[state].wordLength>0 ? state : mNodes[state].outputLink;
+        while (output>0) {
+            int len = mNodes[output].wordLength;
+            matches.append(QPair<int,int>(i-len+1, len));
+            output = mNodes[output].outputLink;
+        }
+    }
+    // leftmost first, longest first for the same start
+    std::sort(matches.begin(), matches.end(),
+              [](const QPair<int,int>& m1, const QPair<int,int>& m2) {
+        if (m1.first != m2.first)
+            return m1.first < m2.first;
+        return m1.second > m2.second;
+    });
+    int end = 0;
+    foreach (const auto& match, matches) {
+        if (match.first < end)
+            continue;
+        mResults.append(match.first);
+        mLengths.append(match.second);
+        end = match.first + match.second;
+    }
+    return mResults.size();
+}
+
+QString MultiPatternSearcher::replace(const QString &, const QString &aReplacement)
+{
+    return aReplacement;
+}
+
+void MultiPatternSearcher::setPattern(const QString &value)
+{
+    Searcher::setPattern(value);
+    mPatterns = value.split('\n');
+    buildAutomaton();
+}
+
+void MultiPatternSearcher::setOptions(const SearchOptions &options)
+{
+    bool matchCaseChanged = options.testFlag(ssoMatchCase) != this->options().testFlag(ssoMatchCase);
+    Searcher::setOptions(options);
+    if (matchCaseChanged)
+        buildAutomaton();
+}
+
+void MultiPatternSearcher::buildAutomaton()
+{
+    mNodes.clear();
+    mNodes.append(Node{{},0,0,0});
+    foreach (const QString& word, mPatterns) {
+        if (word.isEmpty())
+            continue;
+        int state = 0;
+        for (int i=0;i<word.length();i++) {
+            ushort ch = normalize(word[i]);
+            int nextState = mNodes[state].next.value(ch, -1);
+            if (nextState<0) {
+                nextState = mNodes.count();
+                mNodes.append(Node{{},0,0,0});
+                mNodes[state].next.insert(ch, nextState);
+            }
+            state = nextState;
+        }
+        mNodes[state].wordLength = word.length();
+    }
+    // set fail links breadth first, so the fail node of a node is always ready
+    QQueue<int> queue;
+    foreach (int child, mNodes[0].next)
+        queue.enqueue(child);
+    while (!queue.isEmpty()) {
+        int state = queue.dequeue();
+        for (auto it = mNodes[state].next.constBegin(); it != mNodes[state].next.constEnd(); ++it) {
+            ushort ch = it.key();
+            int child = it.value();
+            int fail = mNodes[state].fail;
+            while (fail>0 && !mNodes[fail].next.contains(ch))
+                fail = mNodes[fail].fail;
+            fail = mNodes[fail].next.value(ch, 0);
+            mNodes[child].fail = fail;
+            mNodes[child].outputLink = mNodes[fail].wordLength>0 ? fail : mNodes[fail].outputLink;
+            queue.enqueue(child);
+        }
+    }
+}
+
+ushort MultiPatternSearcher::normalize(const QChar &ch) const
+{
+    if (options().testFlag(ssoMatchCase))
+        return ch.unicode();
+    return ch.toCaseFolded().unicode();
+}
+
+}
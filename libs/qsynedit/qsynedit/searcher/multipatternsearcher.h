@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SYNSEARCHMULTIPATTERN_H
+#define SYNSEARCHMULTIPATTERN_H
+#include "baseseacher.h"
+
+#include <QHash>
+#include <QVector>
+
+namespace QSynedit {
+
+/**
+ * @brief Searches many words at once, using the Aho-Corasick automaton.
+ *
+ * The pattern is a list of words separated by '\n'. Like BasicSearcher,
+ * the results in a line don't overlap. If several words match at the same
+ * position, the longest one is used.
+ */
+class MultiPatternSearcher : public Searcher
+{
+    Q_OBJECT
+public:
+    explicit MultiPatternSearcher(QObject* parent=nullptr);
+    void setPatterns(const QStringList& patterns);
+
+    // SynSearchBase interface
+public:
+    int length(int aIndex) override;
+    int result(int aIndex) override;
+    int resultCount() override;
+    int findAll(const QString &text) override;
+    QString replace(const QString &aOccurrence, const QString &aReplacement) override;
+    void setPattern(const QString &value) override;
+    void setOptions(const SearchOptions &options) override;
+private:
+    struct Node {
+        QHash<ushort,int> next;
+        int fail;
+        // length of the longest word ending at this node, 0 if none
+        int wordLength;
+        // the nearest node on the fail chain that ends a word
+        int outputLink;
+    };
+    void buildAutomaton();
+    ushort normalize(const QChar& ch) const;
+private:
+    QStringList mPatterns;
+    QVector<Node> mNodes;
+    QList<int> mLengths;
+    QList<int> mResults;
+};
+
+}
+
+#endif // SYNSEARCHMULTIPATTERN_H
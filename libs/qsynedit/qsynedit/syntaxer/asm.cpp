@@ -1704,7 +1704,7 @@ PSyntaxState ASMSyntaxer::getState() const
 {
     PSyntaxState state = std::make_shared<SyntaxState>();
     state->hasTrailingSpaces = mHasTrailingSpaces;
-    return state;
+    return shareState(state);
 }
 
 void ASMSyntaxer::setState(const PSyntaxState&)
@@ -1838,7 +1838,7 @@ PSyntaxState CppSyntaxer::getState() const
     std::shared_ptr<CppSyntaxState> syntaxstate = std::make_shared<CppSyntaxState>();
     *syntaxstate = mRange;
     syntaxstate->tokenId = mTokenId;
-    return syntaxstate;
+    return shareState(syntaxstate);
 
 }
 
@@ -1868,6 +1868,8 @@ QString CppSyntaxer::foldString(QString endLine)
 
 bool CppSyntaxer::CppSyntaxState::equals(const std::shared_ptr<SyntaxState> &s2) const
 {
+    if (s2.get() == this)
+        return true;
     if (SyntaxState::equals(s2)) {
         std::shared_ptr<CppSyntaxState> cppS2 = std::dynamic_pointer_cast<CppSyntaxState>(s2);
         return initialDCharSeq == cppS2->initialDCharSeq
@@ -1880,4 +1882,10 @@ bool CppSyntaxer::CppSyntaxState::equals(const std::shared_ptr<SyntaxState> &s2)
         return false;
 }
 
+bool CppSyntaxer::CppSyntaxState::identical(const std::shared_ptr<SyntaxState> &s2) const
+{
+    return SyntaxState::identical(s2)
+            && tokenId == std::dynamic_pointer_cast<CppSyntaxState>(s2)->tokenId;
+}
+
 }
@@ -78,6 +78,7 @@ public:
         TokenId tokenId;
 
         bool equals(const std::shared_ptr<SyntaxState>& s2) const override;
+        bool identical(const std::shared_ptr<SyntaxState>& s2) const override;
     };
 
     using PCppSyntaxState = std::shared_ptr<CppSyntaxState>;
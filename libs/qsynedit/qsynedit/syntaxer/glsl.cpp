@@ -1413,7 +1413,7 @@ PSyntaxState GLSLSyntaxer::getState() const
 {
     PSyntaxState pSyntaxState = std::make_shared<SyntaxState>();
     *pSyntaxState = mRange;
-    return pSyntaxState;
+    return shareState(pSyntaxState);
 }
 
 QSet<QString> GLSLSyntaxer::keywords() const
@@ -1197,7 +1197,7 @@ PSyntaxState LuaSyntaxer::getState() const
 {
     PSyntaxState syntaxState = std::make_shared<SyntaxState>();
     *syntaxState = mRange;
-    return syntaxState;
+    return shareState(syntaxState);
 }
 
 bool LuaSyntaxer::isIdentChar(const QChar &ch) const
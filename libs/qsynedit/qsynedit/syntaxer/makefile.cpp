@@ -666,7 +666,7 @@ PSyntaxState MakefileSyntaxer::getState() const
     PSyntaxState state = std::make_shared<SyntaxState>();
     state->state = (int)mState;
     state->hasTrailingSpaces = mHasTrailingSpaces;
-    return state;
+    return shareState(state);
 }
 
 void MakefileSyntaxer::setState(const PSyntaxState & rangeState)
@@ -156,6 +156,14 @@ QString Syntaxer::blockCommentEndSymbol() const
     return QString();
 }
 
+PSyntaxState Syntaxer::shareState(const PSyntaxState &state) const
+{
+    if (mLastSharedState && state->identical(mLastSharedState))
+        return mLastSharedState;
+    mLastSharedState = state;
+    return state;
+}
+
 TokenAttribute::TokenAttribute(const QString &name, TokenType tokenType):
     mForeground(QColor()),
     mBackground(QColor()),
@@ -170,6 +178,8 @@ bool SyntaxState::equals(const std::shared_ptr<SyntaxState> &s2) const
 {
     if (s2 == nullptr)
         return false;
+    if (s2.get() == this)
+        return true;
     // indents contains the information of brace/parenthesis/brackets embedded levels
     return (state == s2->state)
             && (blockLevel == s2->blockLevel) // needed by block folding
@@ -184,6 +194,11 @@ bool SyntaxState::equals(const std::shared_ptr<SyntaxState> &s2) const
             ;
 }
 
+bool SyntaxState::identical(const std::shared_ptr<SyntaxState> &s2) const
+{
+    return equals(s2) && hasTrailingSpaces == s2->hasTrailingSpaces;
+}
+
 IndentInfo SyntaxState::getLastIndent()
 {
     if (indents.isEmpty())
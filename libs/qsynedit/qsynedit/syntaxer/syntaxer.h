@@ -61,6 +61,8 @@ struct SyntaxState {
     bool hasTrailingSpaces;
 
     virtual bool equals(const std::shared_ptr<SyntaxState>& s2) const;
+    // equals() and all other fields are the same, so one can be used in place of the other
+    virtual bool identical(const std::shared_ptr<SyntaxState>& s2) const;
     IndentInfo getLastIndent();
     IndentType getLastIndentType();
     SyntaxState();
@@ -189,10 +191,14 @@ protected:
     void addAttribute(PTokenAttribute attribute) { mAttributes[attribute->name()]=attribute; }
     void clearAttributes() { mAttributes.clear(); }
     virtual int attributesCount() const { return mAttributes.size(); }
+    // return the last shared state instead if it's identical to the new one,
+    // so consecutive lines with the same state share one object
+    PSyntaxState shareState(const PSyntaxState& state) const;
 
 private:
     QMap<QString,PTokenAttribute> mAttributes;
     QSet<QChar> mWordBreakChars;
+    mutable PSyntaxState mLastSharedState;
 };
 
 using PSyntaxer = std::shared_ptr<Syntaxer>;
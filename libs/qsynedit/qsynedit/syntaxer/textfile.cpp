@@ -125,7 +125,7 @@ PSyntaxState TextSyntaxer::getState() const
     PSyntaxState state = std::make_shared<SyntaxState>();
     state->state = (int)mState;
     state->hasTrailingSpaces = mHasTrailingSpaces;
-    return state;
+    return shareState(state);
 }
 
 void TextSyntaxer::setState(const PSyntaxState & rangeState)
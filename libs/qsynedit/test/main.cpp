@@ -29,6 +29,11 @@ int main(int argc, char *argv[]) {
         status |= QTest::qExec(&tc, argc, argv);
     }
 
+    {
+        QSynedit::TestDocumentBenchmark tc;
+        status |= QTest::qExec(&tc, argc, argv);
+    }
+
     //Cpp Syntaxer Test
     {
         TestCppSyntaxer tc;
@@ -438,3 +438,21 @@ void TestCppSyntaxer::test_ansi_c_comments()
                                      "*/"
                                  }));
 }
+
+void TestCppSyntaxer::test_identical_states_shared()
+{
+    mSyntaxer.resetState();
+    mSyntaxer.setLine(0,"int a;",1);
+    mSyntaxer.nextToEol();
+    QSynedit::PSyntaxState state1 = mSyntaxer.getState();
+    mSyntaxer.setLine(1,"int b;",2);
+    mSyntaxer.nextToEol();
+    QSynedit::PSyntaxState state2 = mSyntaxer.getState();
+    QCOMPARE(state1.get(), state2.get());
+
+    mSyntaxer.setLine(2,"/* int c;",3);
+    mSyntaxer.nextToEol();
+    QSynedit::PSyntaxState state3 = mSyntaxer.getState();
+    QVERIFY(state3.get() != state2.get());
+    QVERIFY(!state3->equals(state2));
+}
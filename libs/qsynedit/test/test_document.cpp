@@ -1,7 +1,12 @@
 #include <QTest>
 #include <QCoreApplication>
+#include <QTemporaryFile>
+#include <QFile>
 #include "test_document.h"
 #include "qsynedit/document.h"
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
 
 namespace QSynedit {
 
@@ -100,6 +105,23 @@ void TestDocument::test_load_from_empty_file()
     QVERIFY(mDoc->empty());
 }
 
+void TestDocument::test_load_from_file_with_crlf()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write("int a;\r\n\r\n// \xe4\xbd\xa0\xe5\xa5\xbd\r\nint b;\r\n");
+    file.close();
+
+    QByteArray encoding;
+    mDoc->loadFromFile(file.fileName(),ENCODING_AUTO_DETECT,encoding);
+    QCOMPARE(encoding, ENCODING_UTF8);
+    QVERIFY(mDoc->getNewlineType() == NewlineType::Windows);
+    QCOMPARE(mDoc->content(), QStringList({"int a;",
+                                           "",
+                                           QString::fromUtf8("// \xe4\xbd\xa0\xe5\xa5\xbd"),
+                                           "int b;"}));
+}
+
 void TestDocument::test_emoji_glyphs()
 {
     QByteArray encoding;
@@ -132,6 +154,22 @@ void TestDocument::test_emoji_glyphs()
 
 }
 
+void TestDocument::test_glyphs_after_put_line()
+{
+    mDoc->setContents({"int a;"});
+    QCOMPARE(mDoc->glyphCount(0),6);
+    QCOMPARE(mDoc->glyph(0,4),"a");
+    QCOMPARE(mDoc->glyphStartChar(0,6),6);
+    QCOMPARE(mDoc->charToGlyphIndex(0,5),5);
+    QCOMPARE(mDoc->charToGlyphIndex(0,10),6);
+
+    mDoc->putLine(0, "a🌴b");
+    QCOMPARE(mDoc->glyphCount(0),3);
+    QCOMPARE(mDoc->glyph(0,1),"🌴");
+    QCOMPARE(mDoc->glyphStartChar(0,2),3);
+    QCOMPARE(mDoc->charToGlyphIndex(0,2),1);
+}
+
 void TestDocument::test_set_text()
 {
     initSignalTest();
@@ -517,6 +555,107 @@ void TestDocument::test_find_last_line_by_seq()
     QCOMPARE(line->lineSeq(), seq);
 }
 
+void TestDocument::test_find_moved_line_by_seq()
+{
+    mDoc->setContents({"int a;","int b;","int c;","int d;","int e;"});
+    size_t seq = mDoc->getLineSeq(1);
+    mDoc->moveLine(1,3);
+    QCOMPARE(mDoc->getLine(3), "int b;");
+    QCOMPARE(mDoc->getLineSeq(3), seq);
+    mDoc->deleteLines(0,2);
+    PDocumentLine line = mDoc->findLineBySeq(seq);
+    QVERIFY(line!=nullptr);
+    QCOMPARE(line->lineText(), "int b;");
+    QCOMPARE(mDoc->getLineSeq(1), seq);
+}
+
+void TestDocument::test_undo_list_limits()
+{
+    UndoList undoList;
+    undoList.setMaxUndoActions(2);
+    for (int i=0;i<3;i++) {
+        undoList.beginBlock(CharPos{i,0},CharPos{i,0},CharPos{i,0},SelectionMode::Normal);
+        undoList.addChange(ChangeReason::Insert,CharPos{i,0},CharPos{i+1,0},QStringList(),SelectionMode::Normal);
+        undoList.endBlock(CharPos{i+1,0},CharPos{i+1,0},CharPos{i+1,0},SelectionMode::Normal);
+    }
+    QCOMPARE(undoList.itemCount(),2);
+    QVERIFY(undoList.fullUndoImposible());
+    QCOMPARE(undoList.popItem()->changeStartPos(),CharPos(2,0));
+    QCOMPARE(undoList.popItem()->changeStartPos(),CharPos(1,0));
+    QCOMPARE(undoList.memoryUsage(),(size_t)0);
+
+    // big texts are compressed
+    undoList.clear();
+    undoList.setMaxUndoActions(0);
+    QStringList text;
+    for (int i=0;i<2000;i++)
+        text.append(QString("int x%1 = %1;").arg(i));
+    undoList.beginBlock(CharPos{0,0},CharPos{0,0},CharPos{0,0},SelectionMode::Normal);
+    undoList.addChange(ChangeReason::Delete,CharPos{0,0},CharPos{0,2000},text,SelectionMode::Normal);
+    undoList.endBlock(CharPos{0,0},CharPos{0,0},CharPos{0,0},SelectionMode::Normal);
+    QVERIFY(undoList.memoryUsage() < (size_t)text.join("").length() * sizeof(QChar));
+    QCOMPARE(undoList.peekItem()->changeText(),text);
+
+    // oldest changes are removed when using too much memory
+    undoList.setMaxMemoryUsage(undoList.memoryUsage());
+    undoList.beginBlock(CharPos{0,0},CharPos{0,0},CharPos{0,0},SelectionMode::Normal);
+    undoList.addChange(ChangeReason::Delete,CharPos{0,0},CharPos{1,0},{"a"},SelectionMode::Normal);
+    undoList.endBlock(CharPos{0,0},CharPos{0,0},CharPos{0,0},SelectionMode::Normal);
+    QCOMPARE(undoList.itemCount(),1);
+    QCOMPARE(undoList.peekItem()->changeText(),QStringList{"a"});
+}
+
+void TestDocument::test_undo_list_limits_initial_state()
+{
+    // saved with an empty undo list
+    UndoList undoList;
+    undoList.setMaxUndoActions(2);
+    undoList.setInitialState();
+    for (int i=0;i<3;i++) {
+        undoList.beginBlock(CharPos{i,0},CharPos{i,0},CharPos{i,0},SelectionMode::Normal);
+        undoList.addChange(ChangeReason::Insert,CharPos{i,0},CharPos{i+1,0},QStringList(),SelectionMode::Normal);
+        undoList.endBlock(CharPos{i+1,0},CharPos{i+1,0},CharPos{i+1,0},SelectionMode::Normal);
+    }
+    QVERIFY(!undoList.initialState());
+    undoList.popItem();
+    undoList.popItem();
+    QCOMPARE(undoList.itemCount(),0);
+    QVERIFY(!undoList.initialState());
+
+    // saved after the first change
+    undoList.clear();
+    undoList.beginBlock(CharPos{0,0},CharPos{0,0},CharPos{0,0},SelectionMode::Normal);
+    undoList.addChange(ChangeReason::Insert,CharPos{0,0},CharPos{1,0},QStringList(),SelectionMode::Normal);
+    undoList.endBlock(CharPos{1,0},CharPos{1,0},CharPos{1,0},SelectionMode::Normal);
+    undoList.setInitialState();
+    QVERIFY(undoList.initialState());
+    for (int i=1;i<4;i++) {
+        undoList.beginBlock(CharPos{i,0},CharPos{i,0},CharPos{i,0},SelectionMode::Normal);
+        undoList.addChange(ChangeReason::Insert,CharPos{i,0},CharPos{i+1,0},QStringList(),SelectionMode::Normal);
+        undoList.endBlock(CharPos{i+1,0},CharPos{i+1,0},CharPos{i+1,0},SelectionMode::Normal);
+    }
+    QCOMPARE(undoList.itemCount(),2);
+    undoList.popItem();
+    QVERIFY(!undoList.initialState());
+    undoList.popItem();
+    QVERIFY(!undoList.initialState());
+
+    // saved state is still in the list
+    undoList.clear();
+    undoList.setMaxUndoActions(3);
+    for (int i=0;i<4;i++) {
+        undoList.beginBlock(CharPos{i,0},CharPos{i,0},CharPos{i,0},SelectionMode::Normal);
+        undoList.addChange(ChangeReason::Insert,CharPos{i,0},CharPos{i+1,0},QStringList(),SelectionMode::Normal);
+        undoList.endBlock(CharPos{i+1,0},CharPos{i+1,0},CharPos{i+1,0},SelectionMode::Normal);
+        if (i==2)
+            undoList.setInitialState();
+    }
+    QCOMPARE(undoList.itemCount(),3);
+    QVERIFY(!undoList.initialState());
+    undoList.popItem();
+    QVERIFY(undoList.initialState());
+}
+
 void TestDocument::test_crash_on_debian_amd_64()
 {
     mDoc=std::make_shared<Document>(QFont{});
@@ -590,4 +729,112 @@ void TestDocumentHelpers::test_searchForSegmentIdx()
     QCOMPARE(searchForSegmentIdx(segments,maxVal,16), 3);
 }
 
+// about 6 MB of text
+static constexpr int BenchmarkLineCount = 100000;
+
+// resident memory of the process, -1 if it's unknown
+static qint64 residentMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile file("/proc/self/statm");
+    if (!file.open(QFile::ReadOnly))
+        return -1;
+    QList<QByteArray> fields = file.readAll().split(' ');
+    if (fields.count()<2)
+        return -1;
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+void TestDocumentBenchmark::initTestCase()
+{
+    mLines.reserve(BenchmarkLineCount);
+    for (int i=0;i<BenchmarkLineCount;i++) {
+        mLines.append(QString("    int variable_%1 = function_call(argument, %1); // comment").arg(i));
+    }
+}
+
+void TestDocumentBenchmark::init()
+{
+    mDoc=std::make_shared<Document>(QFont{"monospace"});
+}
+
+void TestDocumentBenchmark::cleanup()
+{
+    mDoc.reset();
+}
+
+void TestDocumentBenchmark::benchmark_set_contents()
+{
+    QBENCHMARK {
+        mDoc->setContents(mLines);
+    }
+    QCOMPARE(mDoc->count(),BenchmarkLineCount);
+}
+
+void TestDocumentBenchmark::benchmark_load_from_file()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(mLines.join("\n").toUtf8());
+    file.close();
+    QByteArray encoding;
+    QBENCHMARK {
+        mDoc->loadFromFile(file.fileName(),ENCODING_UTF8,encoding);
+    }
+    QCOMPARE(mDoc->count(),BenchmarkLineCount);
+}
+
+void TestDocumentBenchmark::benchmark_insert_delete_line_at_start()
+{
+    mDoc->setContents(mLines);
+    QBENCHMARK {
+        mDoc->insertLine(0,"int x;");
+        mDoc->deleteLine(0);
+    }
+    QCOMPARE(mDoc->count(),BenchmarkLineCount);
+    QCOMPARE(mDoc->getLine(0),mLines[0]);
+}
+
+void TestDocumentBenchmark::benchmark_insert_delete_line_in_middle()
+{
+    mDoc->setContents(mLines);
+    int line = BenchmarkLineCount / 2;
+    QBENCHMARK {
+        mDoc->insertLine(line,"int x;");
+        mDoc->deleteLine(line);
+    }
+    QCOMPARE(mDoc->count(),BenchmarkLineCount);
+    QCOMPARE(mDoc->getLine(line),mLines[line]);
+}
+
+void TestDocumentBenchmark::benchmark_move_line_across_document()
+{
+    mDoc->setContents(mLines);
+    int last = BenchmarkLineCount - 1;
+    QBENCHMARK {
+        mDoc->moveLine(0,last);
+        mDoc->moveLine(last,0);
+    }
+    QCOMPARE(mDoc->getLine(0),mLines[0]);
+    QCOMPARE(mDoc->getLine(last),mLines[last]);
+}
+
+void TestDocumentBenchmark::benchmark_memory()
+{
+    qint64 before = residentMemory();
+    if (before<0)
+        QSKIP("Resident memory is only read on Linux");
+    mDoc->setContents(mLines);
+    qint64 used = residentMemory() - before;
+    qint64 textSize = 0;
+    foreach (const QString& line, mLines)
+        textSize += line.length() * sizeof(QChar);
+    qDebug()<<"text size:"<<textSize<<"bytes, document:"<<used<<"bytes,"
+           <<used / BenchmarkLineCount<<"bytes per line";
+    QTest::setBenchmarkResult(used, QTest::BytesAllocated);
+}
+
 }
@@ -37,7 +37,9 @@ private slots:
     void test_load_from_file();
     void test_load_from_file2();
     void test_load_from_empty_file();
+    void test_load_from_file_with_crlf();
     void test_emoji_glyphs();
+    void test_glyphs_after_put_line();
     void test_set_text();
     void test_set_empty_text();
     void test_set_contents();
@@ -65,11 +67,33 @@ private slots:
     void test_move_line_to2();
     void test_clear();
     void test_find_last_line_by_seq();
+    void test_find_moved_line_by_seq();
+    void test_undo_list_limits();
+    void test_undo_list_limits_initial_state();
 
     void test_crash_on_debian_amd_64();
 
     void initSignalTest();
     void onChanged();
 };
+
+// Editing, loading and memory use of multi-MB documents
+class TestDocumentBenchmark : public QObject
+{
+    Q_OBJECT
+private:
+    QStringList mLines;
+    std::shared_ptr<Document> mDoc;
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void benchmark_set_contents();
+    void benchmark_load_from_file();
+    void benchmark_insert_delete_line_at_start();
+    void benchmark_insert_delete_line_in_middle();
+    void benchmark_move_line_across_document();
+    void benchmark_memory();
+};
 }
 #endif
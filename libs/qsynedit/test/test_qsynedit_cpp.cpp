@@ -2142,6 +2142,72 @@ void TestQSyneditCpp::test_input_char_at_end_of_first_line_of_collapsed_block()
     QVERIFY(!mEdit->isCollapsed(6,8));
 }
 
+void TestQSyneditCpp::test_input_char_in_collapsed_block_keeps_folds()
+{
+    QStringList text1{
+        "int main() {",
+        "\tint x;",
+        "\tif (x>0) {",
+        "\t\tx++;",
+        "\t}",
+        "}"
+    };
+    mEdit->setContent(text1);
+    mEdit->collapse(2,4);
+    QVERIFY(mEdit->isCollapsed(2,4));
+    int rescanCount = 0;
+    connect(mEdit.get(), &QSynEdit::foldsRescaned, this, [&rescanCount](){ rescanCount++; });
+
+    mEdit->setCaretXY(CharPos{6,1});
+    QTest::keyPress(mEdit.get(),'y');
+    QCOMPARE(mEdit->lineText(1),"\tint xy;");
+    QCOMPARE(rescanCount,0);
+    QCOMPARE(mEdit->codeBlockCount(),2);
+    QVERIFY(mEdit->hasCodeBlock(0,5));
+    QVERIFY(mEdit->hasCodeBlock(2,4));
+    QVERIFY(mEdit->isCollapsed(2,4));
+
+    QTest::keyPress(mEdit.get(),Qt::Key_Return);
+    QCOMPARE(rescanCount,0);
+    QCOMPARE(mEdit->codeBlockCount(),2);
+    QVERIFY(mEdit->hasCodeBlock(0,6));
+    QVERIFY(mEdit->hasCodeBlock(3,5));
+    QVERIFY(mEdit->isCollapsed(3,5));
+
+    QTest::keyPress(mEdit.get(),'{');
+    QVERIFY(rescanCount>0);
+    disconnect(mEdit.get(), &QSynEdit::foldsRescaned, this, nullptr);
+}
+
+void TestQSyneditCpp::test_move_line_across_block_end_keeps_folds()
+{
+    QStringList text1{
+        "int main() {",
+        "\tint x;",
+        "}",
+        "int y;"
+    };
+    mEdit->setContent(text1);
+    QCOMPARE(mEdit->codeBlockCount(),1);
+    QVERIFY(mEdit->hasCodeBlock(0,2));
+
+    // "int y;" is moved above the '}'
+    mEdit->setCaretXY(CharPos{0,2});
+    mEdit->moveSelDown();
+    QCOMPARE(mEdit->lineText(2),"int y;");
+    QCOMPARE(mEdit->lineText(3),"}");
+    QCOMPARE(mEdit->codeBlockCount(),1);
+    QVERIFY(mEdit->hasCodeBlock(0,3));
+
+    // "int y;" is moved below the '}'
+    mEdit->setCaretXY(CharPos{0,3});
+    mEdit->moveSelUp();
+    QCOMPARE(mEdit->lineText(2),"}");
+    QCOMPARE(mEdit->lineText(3),"int y;");
+    QCOMPARE(mEdit->codeBlockCount(),1);
+    QVERIFY(mEdit->hasCodeBlock(0,2));
+}
+
 void TestQSyneditCpp::test_input_string_in_empty_file()
 {
     clearContent();
@@ -2623,6 +2689,62 @@ void TestQSyneditCpp::test_input_input_chars_undo()
     QCOMPARE(mEdit->content(),text);
 }
 
+void TestQSyneditCpp::test_input_chars_merged_undo()
+{
+    QStringList text {
+        "01234",
+    };
+    QStringList text1 {
+        "0abc1234",
+    };
+    QStringList text2 {
+        "0abc  1234",
+    };
+    QStringList text3 {
+        "0abc  d1234",
+    };
+    EditorOptions oldOptions = mEdit->getOptions();
+    EditorOptions options = oldOptions;
+    options.setFlag(EditorOption::MergeInputUndo);
+    mEdit->setOptions(options);
+    clearContent();
+    mEdit->setContent(text);
+    mEdit->setCaretXY(CharPos{1,0});
+    QTest::keyPress(mEdit.get(),'a');
+    QTest::keyPress(mEdit.get(),'b');
+    QTest::keyPress(mEdit.get(),'c');
+    QTest::keyPress(mEdit.get(),' ');
+    QTest::keyPress(mEdit.get(),' ');
+    QTest::keyPress(mEdit.get(),'d');
+    QCOMPARE(mEdit->content(),text3);
+
+    clearSignalDatas();
+    mEdit->undo();
+    QCOMPARE(mEdit->content(),text2);
+    QCOMPARE(mEdit->caretXY(),CharPos(6,0));
+    QCOMPARE(mReparseStarts, QList<int>({0}));
+    QCOMPARE(mReparseCounts, QList<int>({1}));
+
+    clearSignalDatas();
+    mEdit->undo();
+    QCOMPARE(mEdit->content(),text1);
+    QCOMPARE(mReparseStarts, QList<int>({0}));
+    QCOMPARE(mReparseCounts, QList<int>({1}));
+
+    clearSignalDatas();
+    mEdit->undo();
+    QCOMPARE(mEdit->content(),text);
+    QCOMPARE(mEdit->caretXY(),CharPos(1,0));
+    QCOMPARE(mReparseStarts, QList<int>({0}));
+    QCOMPARE(mReparseCounts, QList<int>({1}));
+    QVERIFY(!mEdit->canUndo());
+
+    mEdit->redo();
+    QCOMPARE(mEdit->content(),text1);
+    QCOMPARE(mEdit->caretXY(),CharPos(4,0));
+    mEdit->setOptions(oldOptions);
+}
+
 void TestQSyneditCpp::test_input_tab_in_empty_file()
 {
     clearContent();
@@ -10988,5 +11110,132 @@ void TestQSyneditCpp::test_auto_indent_for_parenthesis()
     QVERIFY(!mEdit->canUndo());
 }
 
+QStringList TestQSyneditCpp::bigContent()
+{
+    // more lines than the editor scans at once,
+    // a comment started at the first line ends near the end
+    QStringList text;
+    for (int i=0;i<6000;i++) {
+        if (i==5990)
+            text.append("*/");
+        else
+            text.append(QString("int x%1;").arg(i));
+    }
+    return text;
+}
+
+void TestQSyneditCpp::verifyLineStates()
+{
+    CppSyntaxer syntaxer;
+    QList<PSyntaxState> states = parseLineStates(&syntaxer, mEdit->content());
+    QCOMPARE(states.count(), mEdit->lineCount());
+    for (int i=0;i<states.count();i++) {
+        if (!states[i]->equals(mEdit->lineSyntaxState(i)))
+            QFAIL(QString("wrong state at line %1").arg(i).toUtf8());
+    }
+}
+
+void TestQSyneditCpp::test_async_reparse_input_comment_start()
+{
+    QStringList text = bigContent();
+    mEdit->setContent(text);
+    mEdit->setCaretXY(CharPos{0,0});
+    clearSignalDatas();
+    QTest::keyPress(mEdit.get(),'/');
+    QTest::keyPress(mEdit.get(),'*');
+    QCOMPARE(mEdit->lineText(0),"/*int x0;");
+    // lines out of the window are left to be scanned later
+    QVERIFY(mReparseStarts.count()>=2);
+    QCOMPARE(mReparseStarts.last(),0);
+    QVERIFY(mReparseCounts.last()<text.count());
+
+    // readers get the real state, not the one before the change
+    CppSyntaxer syntaxer;
+    QVERIFY(syntaxer.isCommentNotFinished(mEdit->lineSyntaxState(9)));
+    QVERIFY(syntaxer.isCommentNotFinished(mEdit->lineSyntaxState(5989)));
+    QVERIFY(!syntaxer.isCommentNotFinished(mEdit->lineSyntaxState(5990)));
+    verifyLineStates();
+
+    // tokens of the pending lines
+    mEdit->setContent(text);
+    mEdit->setCaretXY(CharPos{0,0});
+    QTest::keyPress(mEdit.get(),'/');
+    QTest::keyPress(mEdit.get(),'*');
+    QString token;
+    PTokenAttribute attr;
+    QVERIFY(mEdit->getTokenAttriAtRowCol(CharPos{0,5000},token,attr));
+    QVERIFY(attr->tokenType() == TokenType::Comment);
+    QVERIFY(mEdit->getTokenAttriAtRowCol(CharPos{0,5999},token,attr));
+    QCOMPARE(token, "int");
+    verifyLineStates();
+}
+
+void TestQSyneditCpp::test_async_reparse_insert_delete_lines()
+{
+    QStringList text = bigContent();
+    QList<int> lines{1, 100, 3000, 5999};
+    foreach (int line, lines) {
+        // insert lines before, in and after the pending lines
+        mEdit->setContent(text);
+        mEdit->setCaretXY(CharPos{0,0});
+        QTest::keyPress(mEdit.get(),'/');
+        QTest::keyPress(mEdit.get(),'*');
+        mEdit->setCaretXY(CharPos{0,line});
+        QTest::keyPress(mEdit.get(),Qt::Key_Return);
+        QTest::keyPress(mEdit.get(),Qt::Key_Return);
+        QCOMPARE(mEdit->lineCount(),text.count()+2);
+        verifyLineStates();
+
+        // delete lines before, in and after the pending lines
+        mEdit->setContent(text);
+        mEdit->setCaretXY(CharPos{0,0});
+        QTest::keyPress(mEdit.get(),'/');
+        QTest::keyPress(mEdit.get(),'*');
+        mEdit->setCaretXY(CharPos{0,line});
+        mEdit->processCommand(EditCommand::DeleteLine);
+        mEdit->processCommand(EditCommand::DeleteLine);
+        QCOMPARE(mEdit->lineCount(),text.count()-2);
+        verifyLineStates();
+
+        // remove the comment start when lines are still waiting
+        mEdit->setContent(text);
+        mEdit->setCaretXY(CharPos{0,0});
+        QTest::keyPress(mEdit.get(),'/');
+        QTest::keyPress(mEdit.get(),'*');
+        mEdit->setCaretXY(CharPos{0,line});
+        mEdit->processCommand(EditCommand::DeleteLine);
+        mEdit->setCaretXY(CharPos{2,0});
+        QTest::keyPress(mEdit.get(),Qt::Key_Backspace);
+        QTest::keyPress(mEdit.get(),Qt::Key_Backspace);
+        QCOMPARE(mEdit->lineText(0),"int x0;");
+        verifyLineStates();
+    }
+}
+
+void TestQSyneditCpp::test_async_reparse_move_lines()
+{
+    QStringList text = bigContent();
+    QList<int> lines{1, 11, 100, 3000, 5998};
+    foreach (int line, lines) {
+        mEdit->setContent(text);
+        mEdit->setCaretXY(CharPos{0,0});
+        QTest::keyPress(mEdit.get(),'/');
+        QTest::keyPress(mEdit.get(),'*');
+        mEdit->setCaretXY(CharPos{0,line});
+        mEdit->processCommand(EditCommand::MoveSelDown);
+        QCOMPARE(mEdit->lineText(line+1),text[line]);
+        verifyLineStates();
+
+        mEdit->setContent(text);
+        mEdit->setCaretXY(CharPos{0,0});
+        QTest::keyPress(mEdit.get(),'/');
+        QTest::keyPress(mEdit.get(),'*');
+        mEdit->setCaretXY(CharPos{0,line+1});
+        mEdit->processCommand(EditCommand::MoveSelUp);
+        QCOMPARE(mEdit->lineText(line),text[line+1]);
+        verifyLineStates();
+    }
+}
+
 }
 
@@ -56,9 +56,12 @@ private slots:
     void test_input_chars_at_file_begin_end_overwrite_mode();
     void test_input_chars_in_file();
     void test_input_char_at_end_of_first_line_of_collapsed_block();
+    void test_input_char_in_collapsed_block_keeps_folds();
+    void test_move_line_across_block_end_keeps_folds();
     void test_input_string_in_empty_file();
     void test_input_string_in_overwrite_mode();
     void test_input_input_chars_undo();
+    void test_input_chars_merged_undo();
 
     void test_input_tab_in_empty_file();
     void test_block_indent();
@@ -134,6 +137,13 @@ private slots:
     void test_setseltext_and_indent3_line_comment();
 
     void test_auto_indent_for_parenthesis();
+
+    void test_async_reparse_input_comment_start();
+    void test_async_reparse_insert_delete_lines();
+    void test_async_reparse_move_lines();
+private:
+    QStringList bigContent();
+    void verifyLineStates();
 };
 
 }
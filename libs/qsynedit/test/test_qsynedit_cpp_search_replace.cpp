@@ -7,6 +7,7 @@
 #include "qsynedit/syntaxer/cpp.h"
 #include "qsynedit/formatter/cppformatter.h"
 #include "qsynedit/searcher/basicsearcher.h"
+#include "qsynedit/searcher/multipatternsearcher.h"
 #include "qsynedit/searcher/regexsearcher.h"
 
 namespace QSynedit {
@@ -4686,4 +4687,72 @@ void TestQSyneditCppSearchReplace::test_replace_backward_scope()
     QCOMPARE(newEndPos,CharPos(18,2));
 }
 
+void TestQSyneditCppSearchReplace::test_basic_searcher_find_all()
+{
+    BasicSearcher searcher;
+    searcher.setOptions(ssoMatchCase);
+    searcher.setPattern("aa");
+    QCOMPARE(searcher.findAll("aaaAA a"),1);
+    QCOMPARE(searcher.result(0),0);
+    QCOMPARE(searcher.length(0),2);
+
+    searcher.setOptions(ssoNone);
+    QCOMPARE(searcher.findAll("aaaAA a"),2);
+    QCOMPARE(searcher.result(0),0);
+    QCOMPARE(searcher.result(1),2);
+
+    searcher.setPattern("x_Y");
+    QCOMPARE(searcher.findAll("X_y x_ x_yx_Y"),3);
+    QCOMPARE(searcher.result(0),0);
+    QCOMPARE(searcher.result(1),7);
+    QCOMPARE(searcher.result(2),10);
+    QCOMPARE(searcher.findAll("_y"),0);
+
+    searcher.setPattern(QString::fromUtf8("\xc3\x84" "b"));
+    QCOMPARE(searcher.findAll(QString::fromUtf8("\xc3\xa4" "B" "\xc3\x84" "b")),2);
+}
+
+void TestQSyneditCppSearchReplace::test_multi_pattern_searcher_find_all()
+{
+    MultiPatternSearcher searcher;
+    searcher.setOptions(ssoMatchCase);
+    searcher.setPatterns({"he","she","his","hers"});
+    QCOMPARE(searcher.findAll("ushers his"),2);
+    QCOMPARE(searcher.result(0),1);
+    QCOMPARE(searcher.length(0),3);
+    QCOMPARE(searcher.result(1),7);
+    QCOMPARE(searcher.length(1),3);
+
+    searcher.setPattern("int\nprintf\nx");
+    QCOMPARE(searcher.findAll("int x; printf(\"%d\",x); Int"),4);
+    QCOMPARE(searcher.result(0),0);
+    QCOMPARE(searcher.result(1),4);
+    QCOMPARE(searcher.result(2),7);
+    QCOMPARE(searcher.length(2),6);
+    QCOMPARE(searcher.result(3),19);
+
+    searcher.setOptions(ssoNone);
+    QCOMPARE(searcher.findAll("INT X"),2);
+
+    QStringList text1{
+        "int x;",
+        "printf(\"%d\",x);",
+    };
+    QStringList text2{
+        "v v;",
+        "v(\"%d\",v);",
+    };
+    CharPos newEndPos;
+    mEdit->setContent(text1);
+    mEdit->searchReplace("int\nprintf\nx","v",
+                         mEdit->fileBegin(),
+                         mEdit->fileEnd(),
+                         newEndPos,
+                         ssoMatchCase,
+                         &searcher,
+                         mReplaceAndContinueProc,
+                         nullptr);
+    QCOMPARE(mEdit->content(),text2);
+}
+
 }
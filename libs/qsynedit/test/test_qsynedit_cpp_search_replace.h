@@ -68,6 +68,9 @@ private slots:
     void test_replace_backward_from_caret_include_selection();
     void test_replace_forward_scope();
     void test_replace_backward_scope();
+
+    void test_basic_searcher_find_all();
+    void test_multi_pattern_searcher_find_all();
 };
 
 }
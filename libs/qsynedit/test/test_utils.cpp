@@ -38,6 +38,18 @@ QList<TokenInfoList> parseLines(QSynedit::Syntaxer *syntaxer, const QStringList
     return result;
 }
 
+QList<QSynedit::PSyntaxState> parseLineStates(QSynedit::Syntaxer *syntaxer, const QStringList &text)
+{
+    QList<QSynedit::PSyntaxState> result;
+    syntaxer->resetState();
+    for (int i=0;i<text.size();i++) {
+        syntaxer->setLine(i,text[i],i);
+        syntaxer->nextToEol();
+        result.append(syntaxer->getState());
+    }
+    return result;
+}
+
 
 QStringList filterTokens(const QList<TokenInfoList> &infoList, const std::unordered_set<QSynedit::PTokenAttribute> &targetAttributes)
 {
@@ -26,6 +26,10 @@ TokenInfoList parseLine(QSynedit::Syntaxer *syntaxer,
 QList<TokenInfoList> parseLines(QSynedit::Syntaxer *syntaxer,
                                  const QStringList &text);
 
+// states at the end of each line
+QList<QSynedit::PSyntaxState> parseLineStates(QSynedit::Syntaxer *syntaxer,
+                                               const QStringList &text);
+
 QStringList filterTokens(const QList<TokenInfoList> &infoList,
                             const std::unordered_set<QSynedit::PTokenAttribute> &targetAttributes);
 QStringList filterTokens(const QList<TokenInfoList> &infoList,
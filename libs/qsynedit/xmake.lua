@@ -40,6 +40,7 @@ target("qsynedit")
         -- searcher
         "qsynedit/searcher/baseseacher",
         "qsynedit/searcher/basicsearcher",
+        "qsynedit/searcher/multipatternsearcher",
         "qsynedit/searcher/regexsearcher")
 
     add_ui_classes()